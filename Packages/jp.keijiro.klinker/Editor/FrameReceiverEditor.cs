@@ -12,6 +12,8 @@ public sealed class FrameReceiverEditor : Editor
     {
         SerializedProperty _deviceSelection;
         SerializedProperty _queueLength;
+        SerializedProperty _zeroCopyFrames;
+        SerializedProperty _tenBitCapture;
         SerializedProperty _targetTexture;
         SerializedProperty _targetRenderer;
         SerializedProperty _targetMaterialProperty;
@@ -30,6 +32,8 @@ void OnEnable()
         {
             _deviceSelection = serializedObject.FindProperty("_deviceSelection");
             _queueLength = serializedObject.FindProperty("_queueLength");
+            _zeroCopyFrames = serializedObject.FindProperty("_zeroCopyFrames");
+            _tenBitCapture = serializedObject.FindProperty("_tenBitCapture");
             _targetTexture = serializedObject.FindProperty("_targetTexture");
             _targetRenderer = serializedObject.FindProperty("_targetRenderer");
             _targetMaterialProperty = serializedObject.FindProperty("_targetMaterialProperty");
@@ -56,6 +60,8 @@ public override void OnInspectorGUI()
             }
 
             EditorGUILayout.PropertyField(_queueLength);
+            EditorGUILayout.PropertyField(_zeroCopyFrames);
+            EditorGUILayout.PropertyField(_tenBitCapture);
 
             // Target texture/renderer
             EditorGUILayout.PropertyField(_targetTexture);
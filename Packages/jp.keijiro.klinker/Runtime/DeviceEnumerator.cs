@@ -11,6 +11,52 @@ namespace Klinker
     // Provides lists of available devices and video formats.
     public static class DeviceEnumerator
     {
+        #region Data structures
+
+        // Pixel formats (bit order of the native probing list)
+        [System.Flags]
+        public enum PixelFormats : uint
+        {
+            YUV8Bit     = 1 << 0,
+            YUV10Bit    = 1 << 1,
+            ARGB8Bit    = 1 << 2,
+            BGRA8Bit    = 1 << 3,
+            RGB10Bit    = 1 << 4,
+            RGB12Bit    = 1 << 5,
+            RGB12BitLE  = 1 << 6,
+            RGBX10BitLE = 1 << 7,
+            RGBX10Bit   = 1 << 8
+        }
+
+        // Device IDs (zero: not available)
+        // Should be kept in sync with klinker::DeviceIDs.
+        [StructLayout(LayoutKind.Sequential)]
+        public struct DeviceIDs
+        {
+            public long persistentID;
+            public long topologicalID;
+        }
+
+        // Display mode descriptor
+        // Should be kept in sync with klinker::DisplayModeDescriptor.
+        [StructLayout(LayoutKind.Sequential)]
+        public struct DisplayMode
+        {
+            public uint mode;           // BMDDisplayMode (FourCC)
+            public int width;
+            public int height;
+            public uint fieldDominance; // BMDFieldDominance (FourCC)
+            public long frameDuration;  // in flicks
+            public PixelFormats inputPixelFormats;
+            public PixelFormats outputPixelFormats;
+
+            public double FrameRate => 705600000.0 / frameDuration;
+            public bool IsInputAvailable => inputPixelFormats != 0;
+            public bool IsOutputAvailable => outputPixelFormats != 0;
+        }
+
+        #endregion
+
         #region Enumeration methods
 
         // Scan available devices and return their names via a newly allocated
@@ -51,11 +97,35 @@ public static void GetDeviceNames(int deviceIndex, ICollection<string> store)
             for (var i = 0; i < count; i++) store.Add(Marshal.PtrToStringBSTR(_pointers[i]));
         }
 
+        // Retrieve the persistent/topological IDs of the available devices
+        // (in the same order as the device names). These IDs don't change
+        // on hotplugging, unlike the device indices.
+        public static DeviceIDs[] GetDeviceIDs()
+        {
+            var count = EnumeratorPlugin.RetrieveDeviceIDs(_ids, _ids.Length);
+            var ids = new DeviceIDs[count];
+            System.Array.Copy(_ids, ids, count);
+            return ids;
+        }
+
+        // Retrieve the display modes (including input-only ones) on a
+        // specified device. The output modes come first in the same order
+        // as the output format names.
+        public static DisplayMode[] GetDisplayModes(int deviceIndex)
+        {
+            var count = EnumeratorPlugin.RetrieveDisplayModes(deviceIndex, _modes, _modes.Length);
+            var modes = new DisplayMode[count];
+            System.Array.Copy(_modes, modes, count);
+            return modes;
+        }
+
         #endregion
 
         #region Private members
 
         static System.IntPtr[] _pointers = new System.IntPtr[256];
+        static DeviceIDs[] _ids = new DeviceIDs[256];
+        static DisplayMode[] _modes = new DisplayMode[256];
 
         #endregion
     }
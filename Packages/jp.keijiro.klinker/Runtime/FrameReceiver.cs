@@ -15,7 +15,9 @@ public sealed class FrameReceiver : MonoBehaviour
         #region Editable attribute
 
         [SerializeField] int _deviceSelection = 0;
-        [SerializeField, Range(1, 6)] int _queueLength = 3;
+        [SerializeField, Range(0, 6)] int _queueLength = 3;
+        [SerializeField, Range(0, 8)] int _zeroCopyFrames = 0;
+        [SerializeField] bool _tenBitCapture = false;
 
         #endregion
 
@@ -70,59 +72,17 @@ public sealed class FrameReceiver : MonoBehaviour
 
         #region Input queue control
 
-        long _frameTime;
-        bool _prerolled;
+        long _presentationTime;
         int _fieldCount;
 
         bool UpdateQueue()
         {
-            // At least it should have one frame in the queue.
-            if (_plugin.QueuedFrameCount == 0) return false;
+            // Advance the presentation time. Use master clock when available.
+            _presentationTime += FrameSender.master?.frameDuration ?? Util.DeltaTimeInFlicks;
 
-            // Prerolling
-            if (!_prerolled)
-            {
-                if (_plugin.QueuedFrameCount < 1 + _queueLength)
-                    return false;
-                else
-                    _prerolled = true;
-            }
-
-            // Overqueuing detection and recovery
-            var maxQueue = _queueLength + Mathf.Min(3, _queueLength);
-            while (_plugin.QueuedFrameCount > maxQueue)
-            {
-                _plugin.DequeueFrame();
-                _dropDetector.Warn();
-            }
-
-            // Advane the frame time. Use master clock when available.
-            _frameTime += FrameSender.master?.frameDuration ?? Util.DeltaTimeInFlicks;
-
-            // Move to the even field.
-            _fieldCount = 1;
-
-            // Dequeue input frames that are in the previous frame duration.
-            var duration = _plugin.FrameDuration;
-            while (_frameTime >= duration)
-            {
-                // If there is no frame to dequeue, restart from prerolling.
-                if (_plugin.QueuedFrameCount < 2)
-                {
-                    _prerolled = false;
-                    _dropDetector.Warn();
-                    break;
-                }
-
-                // Dequeuing
-                _plugin.DequeueFrame();
-                _frameTime -= duration;
-
-                // Move back to the odd field.
-                _fieldCount = 0;
-            }
-
-            return true;
+            // Frame rate matching is done in the native plugin.
+            _fieldCount = _plugin.SelectFrameForTime(_presentationTime);
+            return _fieldCount >= 0;
         }
 
         #endregion
@@ -141,7 +101,14 @@ bool UpdateQueue()
 
         void Start()
         {
-            _plugin = new ReceiverPlugin(_deviceSelection, 0);
+            var settings = new ReceiverPlugin.Settings();
+            settings.maxRetainedFrames = _zeroCopyFrames;
+            settings.prerollLength = _queueLength;
+            settings.captureFormat = _tenBitCapture ?
+                ReceiverPlugin.CaptureFormat.YUV10 :
+                ReceiverPlugin.CaptureFormat.YUV8;
+
+            _plugin = new ReceiverPlugin(_deviceSelection, 0, settings);
             _upsampler = new Material(Shader.Find("Hidden/Klinker/Upsampler"));
             _dropDetector = new DropDetector(gameObject.name);
         }
@@ -161,11 +128,17 @@ void Update()
             // Update input queue; Break if it's not ready.
             if (!UpdateQueue()) return;
 
+            // Source texture format: UYVY (8-bit) or half-precision UYVY
+            // (unpacked 10-bit)
+            var format = _plugin.BytesPerPixel == 4 ?
+                TextureFormat.RGBAHalf : TextureFormat.RGBA32;
+
             // Renew texture objects when the frame dimensions were changed.
             var dimensions = _plugin.FrameDimensions;
             if (_sourceTexture != null &&
                 (_sourceTexture.width != dimensions.x / 2 ||
-                 _sourceTexture.height != dimensions.y))
+                 _sourceTexture.height != dimensions.y ||
+                 _sourceTexture.format != format))
             {
                 Util.Destroy(_sourceTexture);
                 Util.Destroy(_receivedTexture);
@@ -177,8 +150,7 @@ void Update()
             if (_sourceTexture == null)
             {
                 _sourceTexture = new Texture2D(
-                    dimensions.x / 2, dimensions.y,
-                    TextureFormat.RGBA32, false
+                    dimensions.x / 2, dimensions.y, format, false
                 );
                 _sourceTexture.filterMode = FilterMode.Point;
             }
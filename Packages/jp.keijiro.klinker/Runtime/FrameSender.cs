@@ -174,8 +174,10 @@ IEnumerator Start()
         {
             // Internal objects initialization
             if (_isMaster)
-                _plugin = SenderPlugin.
-                    CreateManualSender(_deviceSelection, _formatSelection);
+                _plugin = SenderPlugin.CreateManualSender(
+                    _deviceSelection, _formatSelection,
+                    new SenderPlugin.Settings { queueLength = _queueLength }
+                );
             else
                 _plugin = SenderPlugin.
                     CreateAsyncSender(_deviceSelection, _formatSelection, _queueLength);
@@ -14,5 +14,11 @@ static class EnumeratorPlugin
 
         [DllImport("Klinker")]
         public static extern int RetrieveOutputFormatNames(int device, IntPtr[] names, int maxCount);
+
+        [DllImport("Klinker")]
+        public static extern int RetrieveDeviceIDs([Out] DeviceEnumerator.DeviceIDs[] ids, int maxCount);
+
+        [DllImport("Klinker")]
+        public static extern int RetrieveDisplayModes(int device, [Out] DeviceEnumerator.DisplayMode[] modes, int maxCount);
     }
 }
@@ -10,6 +10,74 @@ namespace Klinker
     // Wrapper class for native plugin receiver functions
     sealed class ReceiverPlugin : IDisposable
     {
+        #region Receiver settings
+
+        // Should be kept in sync with klinker::OverflowPolicy.
+        public enum OverflowPolicy { DropNewest, DropOldest, Mailbox }
+
+        // Should be kept in sync with klinker::CaptureFormat.
+        public enum CaptureFormat { YUV8, YUV10 }
+
+        // Should be kept in sync with klinker::ReceiverSettings.
+        [StructLayout(LayoutKind.Sequential)]
+        public struct Settings
+        {
+            public int maxRetainedFrames;
+            public int useFrameAllocator;
+            public int useLargePages;
+            public int queueDepth;
+            public int prerollLength;
+            public OverflowPolicy overflowPolicy;
+            public CaptureFormat captureFormat;
+            public int audioChannelCount;
+            public int audioSampleDepth;
+        }
+
+        // Should be kept in sync with klinker::ConvertFormat.
+        public enum ConvertFormat { RGBA8, BGRA8, RGBAHalf }
+
+        // Should be kept in sync with klinker::FieldMode.
+        public enum FieldMode { Progressive, OddField, EvenField }
+
+        // Should be kept in sync with klinker::DropCounters.
+        [StructLayout(LayoutKind.Sequential)]
+        public struct DropCounters
+        {
+            public int newest;
+            public int oldest;
+            public int superseded;
+            public int overqueue;
+            public int underrun;
+            public int pinned;
+        }
+
+        // Should be kept in sync with klinker::AllocatorStats.
+        [StructLayout(LayoutKind.Sequential)]
+        public struct AllocatorStats
+        {
+            public long allocationCount;
+            public long systemAllocations;
+            public long activeBuffers;
+            public long peakActiveBuffers;
+            public long reservedBytes;
+            public long peakReservedBytes;
+            public int largePages;
+        }
+
+        // Should be kept in sync with klinker::LatencyStats (microseconds).
+        [StructLayout(LayoutKind.Sequential)]
+        public struct LatencyStats
+        {
+            public long count;
+            public long mean;
+            public long p50;
+            public long p90;
+            public long p99;
+            public long max;
+        }
+
+        #endregion
+
         #region Disposable pattern
 
         public ReceiverPlugin(int device, int format)
@@ -18,6 +86,26 @@ public ReceiverPlugin(int device, int format)
             CheckError();
         }
 
+        public ReceiverPlugin(int device, int format, Settings settings)
+        {
+            _plugin = CreateReceiverWithSettings(device, format, ref settings);
+            CheckError();
+        }
+
+        // Open a device by its persistent/topological ID with a display mode
+        // code (BMDDisplayMode FourCC).
+        public ReceiverPlugin(long deviceID, uint mode)
+        {
+            _plugin = CreateReceiverByID(deviceID, mode);
+            CheckError();
+        }
+
+        public ReceiverPlugin(long deviceID, uint mode, Settings settings)
+        {
+            _plugin = CreateReceiverByIDWithSettings(deviceID, mode, ref settings);
+            CheckError();
+        }
+
         ~ReceiverPlugin()
         {
             if (_plugin != IntPtr.Zero)
@@ -52,6 +140,10 @@ public void Dispose()
             return GetReceiverFrameDuration(_plugin);
         } }
 
+        public int BytesPerPixel { get {
+            return GetReceiverBytesPerPixel(_plugin);
+        } }
+
         public bool IsProgressive { get {
             return IsReceiverProgressive(_plugin) != 0;
         } }
@@ -71,6 +163,26 @@ public void Dispose()
             return Util.BcdTimecodeToFlicks(packed, FrameDuration);
         } }
 
+        public long StreamTime { get {
+            return GetReceiverStreamTime(_plugin);
+        } }
+
+        public long HardwareTime { get {
+            return GetReceiverHardwareTime(_plugin);
+        } }
+
+        public int AudioChannelCount { get {
+            return GetReceiverAudioChannelCount(_plugin);
+        } }
+
+        public int QueuedAudioFrameCount { get {
+            return CountReceiverAudioFrames(_plugin);
+        } }
+
+        public long AudioOverrunCount { get {
+            return CountReceiverAudioOverruns(_plugin);
+        } }
+
         public IntPtr TextureUpdateCallback { get {
             return GetTextureUpdateCallback();
         } }
@@ -79,6 +191,24 @@ public void Dispose()
             return CountDroppedReceiverFrames(_plugin);
         } }
 
+        public DropCounters DropCountersByPolicy { get {
+            var counters = new DropCounters();
+            GetReceiverDropCounters(_plugin, out counters);
+            return counters;
+        } }
+
+        public AllocatorStats FrameAllocatorStats { get {
+            var stats = new AllocatorStats();
+            GetReceiverAllocatorStats(_plugin, out stats);
+            return stats;
+        } }
+
+        public Statistics Stats { get {
+            var stats = new Statistics();
+            GetReceiverStats(_plugin, out stats);
+            return stats;
+        } }
+
         #endregion
 
         #region Public methods
@@ -89,6 +219,51 @@ public void DequeueFrame()
             CheckError();
         }
 
+        // Advance the presentation time and select the frame to present.
+        // Returns the field to present (0: odd/progressive, 1: even), or -1
+        // when it's not ready.
+        public int SelectFrameForTime(long time)
+        {
+            return SelectReceiverFrameForTime(_plugin, time);
+        }
+
+        // Latency histograms: arrival to dequeue and arrival to upload
+        public void GetLatencyStats(out LatencyStats dequeue, out LatencyStats upload)
+        {
+            GetReceiverLatencyStats(_plugin, out dequeue, out upload);
+        }
+
+        public void ResetLatencyStats()
+        {
+            ResetReceiverLatencyStats(_plugin);
+        }
+
+        // Pull interleaved audio samples into a given buffer. Returns the
+        // number of the sample frames pulled. This doesn't allocate, so it
+        // can be used in OnAudioFilterRead.
+        public int PullAudio(float[] buffer, out long streamTime)
+        {
+            var channels = AudioChannelCount;
+            streamTime = 0;
+            if (channels == 0) return 0;
+            return PullReceiverAudio(
+                _plugin, buffer, buffer.Length / channels, out streamTime
+            );
+        }
+
+        // Convert the oldest frame into RGB on the CPU. Returns false if
+        // there is no frame to convert.
+        public bool ConvertFrame(
+            IntPtr dest, int destRowBytes,
+            ConvertFormat format, FieldMode field, bool linear
+        )
+        {
+            return ConvertReceiverFrame(
+                _plugin, dest, destRowBytes,
+                (int)format, (int)field, linear ? 1 : 0
+            ) != 0;
+        }
+
         #endregion
 
         #region Error handling
@@ -112,6 +287,15 @@ void CheckError()
         [DllImport("Klinker")]
         static extern IntPtr CreateReceiver(int device, int format);
 
+        [DllImport("Klinker")]
+        static extern IntPtr CreateReceiverWithSettings(int device, int format, ref Settings settings);
+
+        [DllImport("Klinker")]
+        static extern IntPtr CreateReceiverByID(long deviceID, uint mode);
+
+        [DllImport("Klinker")]
+        static extern IntPtr CreateReceiverByIDWithSettings(long deviceID, uint mode, ref Settings settings);
+
         [DllImport("Klinker")]
         static extern void DestroyReceiver(IntPtr receiver);
 
@@ -127,6 +311,9 @@ void CheckError()
         [DllImport("Klinker")]
         static extern long GetReceiverFrameDuration(IntPtr receiver);
 
+        [DllImport("Klinker")]
+        static extern int GetReceiverBytesPerPixel(IntPtr receiver);
+
         [DllImport("Klinker")]
         static extern int IsReceiverProgressive(IntPtr receiver);
 
@@ -139,15 +326,61 @@ void CheckError()
         [DllImport("Klinker")]
         static extern void DequeueReceiverFrame(IntPtr receiver);
 
+        [DllImport("Klinker")]
+        static extern int SelectReceiverFrameForTime(IntPtr receiver, long time);
+
         [DllImport("Klinker")]
         static extern uint GetReceiverTimecode(IntPtr receiver);
 
+        [DllImport("Klinker")]
+        static extern long GetReceiverStreamTime(IntPtr receiver);
+
+        [DllImport("Klinker")]
+        static extern long GetReceiverHardwareTime(IntPtr receiver);
+
         [DllImport("Klinker")]
         static extern IntPtr GetTextureUpdateCallback();
 
         [DllImport("Klinker")]
         static extern int CountDroppedReceiverFrames(IntPtr receiver);
 
+        [DllImport("Klinker")]
+        static extern void GetReceiverDropCounters(IntPtr receiver, out DropCounters counters);
+
+        [DllImport("Klinker")]
+        static extern void GetReceiverStats(IntPtr receiver, out Statistics stats);
+
+        [DllImport("Klinker")]
+        static extern void GetReceiverAllocatorStats(IntPtr receiver, out AllocatorStats stats);
+
+        [DllImport("Klinker")]
+        static extern void GetReceiverLatencyStats(
+            IntPtr receiver, out LatencyStats dequeue, out LatencyStats upload
+        );
+
+        [DllImport("Klinker")]
+        static extern void ResetReceiverLatencyStats(IntPtr receiver);
+
+        [DllImport("Klinker")]
+        static extern int GetReceiverAudioChannelCount(IntPtr receiver);
+
+        [DllImport("Klinker")]
+        static extern int CountReceiverAudioFrames(IntPtr receiver);
+
+        [DllImport("Klinker")]
+        static extern long CountReceiverAudioOverruns(IntPtr receiver);
+
+        [DllImport("Klinker")]
+        static extern int PullReceiverAudio(
+            IntPtr receiver, float[] samples, int frameCount, out long streamTime
+        );
+
+        [DllImport("Klinker")]
+        static extern int ConvertReceiverFrame(
+            IntPtr receiver, IntPtr dest, int destRowBytes,
+            int format, int field, int linear
+        );
+
         [DllImport("Klinker")]
         static extern IntPtr GetReceiverError(IntPtr sender);
 
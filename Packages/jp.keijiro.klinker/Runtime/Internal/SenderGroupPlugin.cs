@@ -0,0 +1,79 @@
+// Klinker - Blackmagic DeckLink plugin for Unity
+// https://github.com/keijiro/Klinker
+
+using UnityEngine;
+using System;
+using System.Runtime.InteropServices;
+
+namespace Klinker
+{
+    // Wrapper class for native plugin sender group functions
+    // Starts multiple senders (created with deferredStart) in phase.
+    sealed class SenderGroupPlugin : IDisposable
+    {
+        #region Disposable pattern
+
+        public SenderGroupPlugin()
+        {
+            _plugin = CreateSenderGroup();
+        }
+
+        ~SenderGroupPlugin()
+        {
+            if (_plugin != IntPtr.Zero)
+                Debug.LogError("Sender group instance should be disposed before finalization.");
+        }
+
+        public void Dispose()
+        {
+            if (_plugin != IntPtr.Zero)
+            {
+                DestroySenderGroup(_plugin);
+                _plugin = IntPtr.Zero;
+            }
+        }
+
+        #endregion
+
+        #region Public methods
+
+        public void Add(SenderPlugin sender)
+        {
+            AddSenderToGroup(_plugin, sender.NativePointer);
+        }
+
+        public bool Start()
+        {
+            return StartSenderGroup(_plugin) != 0;
+        }
+
+        // Phase difference from the first sender in flicks
+        public long GetPhaseDrift(int index)
+        {
+            return GetSenderGroupPhaseDrift(_plugin, index);
+        }
+
+        #endregion
+
+        #region Unmanaged code entry points
+
+        IntPtr _plugin;
+
+        [DllImport("Klinker")]
+        static extern IntPtr CreateSenderGroup();
+
+        [DllImport("Klinker")]
+        static extern void DestroySenderGroup(IntPtr group);
+
+        [DllImport("Klinker")]
+        static extern void AddSenderToGroup(IntPtr group, IntPtr sender);
+
+        [DllImport("Klinker")]
+        static extern int StartSenderGroup(IntPtr group);
+
+        [DllImport("Klinker")]
+        static extern long GetSenderGroupPhaseDrift(IntPtr group, int index);
+
+        #endregion
+    }
+}
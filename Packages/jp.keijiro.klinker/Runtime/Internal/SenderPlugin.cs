@@ -12,6 +12,54 @@ namespace Klinker
     // Wrapper class for native plugin sender functions
     sealed class SenderPlugin : IDisposable
     {
+        #region Plugin data structures
+
+        public enum InputFormat { UYVY, RGBA8, RGBAHalf }
+        public enum OutputFormat { UYVY, V210, BGRA8 }
+        public enum LateFramePolicy { Repeat, Drop, None }
+
+        // Should be kept in sync with klinker::SenderSettings.
+        [StructLayout(LayoutKind.Sequential)]
+        public struct Settings
+        {
+            public InputFormat inputFormat;
+            public OutputFormat outputFormat;
+            public int linearInput;
+            public int audioChannelCount;
+            public int audioSampleDepth;
+            public int minPreroll;
+            public int maxPreroll;
+            public LateFramePolicy latePolicy;
+            public int recoveryLead;
+            public int deferredStart;
+            public int workerThread;
+            public int queueLength;
+        }
+
+        // Should be kept in sync with klinker::AudioOutputStats.
+        [StructLayout(LayoutKind.Sequential)]
+        public struct AudioStats
+        {
+            public long scheduledFrames;
+            public long overruns;
+            public long resyncs;
+            public int queuedFrames;
+            public int bufferedFrames;
+        }
+
+        // Should be kept in sync with klinker::FramePoolStats.
+        [StructLayout(LayoutKind.Sequential)]
+        public struct FramePoolStats
+        {
+            public long acquired;
+            public long exhausted;
+            public int poolSize;
+            public int inUse;
+            public int peakInUse;
+        }
+
+        #endregion
+
         #region Factory methods
 
         public static SenderPlugin CreateAsyncSender(int device, int format, int preroll)
@@ -24,6 +72,46 @@ public static SenderPlugin CreateManualSender(int device, int format)
             return new SenderPlugin(_CreateManualSender(device, format));
         }
 
+        public static SenderPlugin CreateAsyncSender(int device, int format, int preroll, Settings settings)
+        {
+            return new SenderPlugin(
+                CreateAsyncSenderWithSettings(device, format, preroll, ref settings)
+            );
+        }
+
+        public static SenderPlugin CreateManualSender(int device, int format, Settings settings)
+        {
+            return new SenderPlugin(
+                CreateManualSenderWithSettings(device, format, ref settings)
+            );
+        }
+
+        // Open a device by its persistent/topological ID with a display mode
+        // code (BMDDisplayMode FourCC).
+        public static SenderPlugin CreateAsyncSender(long deviceID, uint mode, int preroll)
+        {
+            return new SenderPlugin(CreateAsyncSenderByID(deviceID, mode, preroll));
+        }
+
+        public static SenderPlugin CreateManualSender(long deviceID, uint mode)
+        {
+            return new SenderPlugin(CreateManualSenderByID(deviceID, mode));
+        }
+
+        public static SenderPlugin CreateAsyncSender(long deviceID, uint mode, int preroll, Settings settings)
+        {
+            return new SenderPlugin(
+                CreateAsyncSenderByIDWithSettings(deviceID, mode, preroll, ref settings)
+            );
+        }
+
+        public static SenderPlugin CreateManualSender(long deviceID, uint mode, Settings settings)
+        {
+            return new SenderPlugin(
+                CreateManualSenderByIDWithSettings(deviceID, mode, ref settings)
+            );
+        }
+
         #endregion
 
         #region Disposable pattern
@@ -53,6 +141,8 @@ public void Dispose()
 
         #region Public properties
 
+        public IntPtr NativePointer { get { return _plugin; } }
+
         public Vector2Int FrameDimensions { get {
             return new Vector2Int(
                 GetSenderFrameWidth(_plugin),
@@ -72,27 +162,133 @@ public void Dispose()
             return IsSenderReferenceLocked(_plugin) != 0;
         } }
 
+        public int RowBytes { get {
+            return GetSenderFrameRowBytes(_plugin);
+        } }
+
+        public int InputRowBytes { get {
+            return GetSenderInputRowBytes(_plugin);
+        } }
+
         public int DropCount { get {
             return CountDroppedSenderFrames(_plugin);
         } }
 
+        public int PrerollDepth { get {
+            return GetSenderPrerollDepth(_plugin);
+        } }
+
+        public int BufferedFrameCount { get {
+            return CountSenderBufferedFrames(_plugin);
+        } }
+
+        public long CompletedFeedCount { get {
+            return GetSenderCompletedFeedCount(_plugin);
+        } }
+
+        public long CompletedFrameCount { get {
+            return GetSenderCompletedFrameCount(_plugin);
+        } }
+
+        public long RecoveryCount { get {
+            return CountSenderRecoveries(_plugin);
+        } }
+
+        public Statistics Stats { get {
+            var stats = new Statistics();
+            GetSenderStats(_plugin, out stats);
+            return stats;
+        } }
+
+        public long WaitTimeoutCount { get {
+            return CountSenderWaitTimeouts(_plugin);
+        } }
+
+        // Win32 event handle signaled on reaching the completion fence
+        public IntPtr CompletionEvent { get {
+            return GetSenderCompletionEvent(_plugin);
+        } }
+
+        public FramePoolStats FramePoolStatistics { get {
+            var stats = new FramePoolStats();
+            GetSenderFramePoolStats(_plugin, out stats);
+            return stats;
+        } }
+
+        public AudioStats AudioStatistics { get {
+            var stats = new AudioStats();
+            GetSenderAudioStats(_plugin, out stats);
+            return stats;
+        } }
+
         #endregion
 
         #region Public methods
 
-        public unsafe void FeedFrame<T>(NativeArray<T> data, long timecode) where T : struct
+        // Returns a feed ticket. With the worker thread option, the data
+        // should be kept valid until CompletedFeedCount reaches the ticket.
+        public unsafe long FeedFrame<T>(NativeArray<T> data, long timecode) where T : struct
         {
             var bcd = Util.FlicksToBcdTimecode(timecode, FrameDuration);
-            FeedFrameToSender(_plugin, (IntPtr)data.GetUnsafeReadOnlyPtr(), bcd);
+            var ticket = FeedFrameToSender(_plugin, (IntPtr)data.GetUnsafeReadOnlyPtr(), bcd);
             CheckError();
+            return ticket;
         }
 
-        public void WaitCompletion(long frameNumber)
+        public void WaitFeedCompletion(long ticket)
         {
-            WaitSenderCompletion(_plugin, frameNumber);
+            WaitSenderFeedCompletion(_plugin, ticket);
+        }
+
+        // Direct-write API: Write the frame data into the returned buffer
+        // (RowBytes * height bytes), then commit it.
+        public IntPtr AcquireFrameBuffer()
+        {
+            var buffer = AcquireSenderFrameBuffer(_plugin);
+            CheckError();
+            return buffer;
+        }
+
+        public void CommitFrame(long timecode)
+        {
+            var bcd = Util.FlicksToBcdTimecode(timecode, FrameDuration);
+            CommitSenderFrame(_plugin, bcd);
             CheckError();
         }
 
+        // Push interleaved audio samples. Returns false when the audio ring
+        // is full. It doesn't allocate memory, so it can be used in
+        // OnAudioFilterRead.
+        public bool PushAudio(float[] samples, int channelCount)
+        {
+            return PushSenderAudio(
+                _plugin, samples, samples.Length / channelCount
+            ) != 0;
+        }
+
+        // Returns false on timeout.
+        public bool WaitCompletion(long frameNumber, int timeout = 200)
+        {
+            return WaitSenderCompletionWithTimeout(_plugin, frameNumber, timeout) != 0;
+        }
+
+        // Start the playback of a sender created with deferredStart.
+        public bool StartPlayback()
+        {
+            return StartSenderPlayback(_plugin) != 0;
+        }
+
+        public void SetCompletionFence(long frameNumber)
+        {
+            SetSenderCompletionFence(_plugin, frameNumber);
+        }
+
+        // Native callback: void (*)(void* userData, int64_t completedCount)
+        public void SetCompletionCallback(IntPtr callback, IntPtr userData)
+        {
+            SetSenderCompletionCallback(_plugin, callback, userData);
+        }
+
         #endregion
 
         #region Error handling
@@ -119,6 +315,24 @@ void CheckError()
         [DllImport("Klinker", EntryPoint="CreateManualSender")]
         static extern IntPtr _CreateManualSender(int device, int format);
 
+        [DllImport("Klinker")]
+        static extern IntPtr CreateAsyncSenderWithSettings(int device, int format, int preroll, ref Settings settings);
+
+        [DllImport("Klinker")]
+        static extern IntPtr CreateManualSenderWithSettings(int device, int format, ref Settings settings);
+
+        [DllImport("Klinker")]
+        static extern IntPtr CreateAsyncSenderByID(long deviceID, uint mode, int preroll);
+
+        [DllImport("Klinker")]
+        static extern IntPtr CreateManualSenderByID(long deviceID, uint mode);
+
+        [DllImport("Klinker")]
+        static extern IntPtr CreateAsyncSenderByIDWithSettings(long deviceID, uint mode, int preroll, ref Settings settings);
+
+        [DllImport("Klinker")]
+        static extern IntPtr CreateManualSenderByIDWithSettings(long deviceID, uint mode, ref Settings settings);
+
         [DllImport("Klinker")]
         static extern void DestroySender(IntPtr sender);
 
@@ -138,14 +352,74 @@ void CheckError()
         static extern int IsSenderReferenceLocked(IntPtr sender);
 
         [DllImport("Klinker")]
-        static extern void FeedFrameToSender(IntPtr sender, IntPtr frameData, uint timecode);
+        static extern long FeedFrameToSender(IntPtr sender, IntPtr frameData, uint timecode);
+
+        [DllImport("Klinker")]
+        static extern long GetSenderCompletedFeedCount(IntPtr sender);
+
+        [DllImport("Klinker")]
+        static extern void WaitSenderFeedCompletion(IntPtr sender, long ticket);
+
+        [DllImport("Klinker")]
+        static extern int GetSenderFrameRowBytes(IntPtr sender);
+
+        [DllImport("Klinker")]
+        static extern int GetSenderInputRowBytes(IntPtr sender);
+
+        [DllImport("Klinker")]
+        static extern IntPtr AcquireSenderFrameBuffer(IntPtr sender);
+
+        [DllImport("Klinker")]
+        static extern void CommitSenderFrame(IntPtr sender, uint timecode);
+
+        [DllImport("Klinker")]
+        static extern int PushSenderAudio(IntPtr sender, float[] samples, int frameCount);
+
+        [DllImport("Klinker")]
+        static extern void GetSenderAudioStats(IntPtr sender, out AudioStats stats);
 
         [DllImport("Klinker")]
         static extern void WaitSenderCompletion(IntPtr sender, long frameNumber);
 
+        [DllImport("Klinker")]
+        static extern int WaitSenderCompletionWithTimeout(IntPtr sender, long frameNumber, int timeout);
+
+        [DllImport("Klinker")]
+        static extern long GetSenderCompletedFrameCount(IntPtr sender);
+
+        [DllImport("Klinker")]
+        static extern int StartSenderPlayback(IntPtr sender);
+
+        [DllImport("Klinker")]
+        static extern long CountSenderRecoveries(IntPtr sender);
+
+        [DllImport("Klinker")]
+        static extern void GetSenderStats(IntPtr sender, out Statistics stats);
+
+        [DllImport("Klinker")]
+        static extern long CountSenderWaitTimeouts(IntPtr sender);
+
+        [DllImport("Klinker")]
+        static extern void SetSenderCompletionFence(IntPtr sender, long frameNumber);
+
+        [DllImport("Klinker")]
+        static extern void SetSenderCompletionCallback(IntPtr sender, IntPtr callback, IntPtr userData);
+
+        [DllImport("Klinker")]
+        static extern IntPtr GetSenderCompletionEvent(IntPtr sender);
+
         [DllImport("Klinker")]
         static extern int CountDroppedSenderFrames(IntPtr sender);
 
+        [DllImport("Klinker")]
+        static extern int GetSenderPrerollDepth(IntPtr sender);
+
+        [DllImport("Klinker")]
+        static extern int CountSenderBufferedFrames(IntPtr sender);
+
+        [DllImport("Klinker")]
+        static extern void GetSenderFramePoolStats(IntPtr sender, out FramePoolStats stats);
+
         [DllImport("Klinker")]
         static extern IntPtr GetSenderError(IntPtr sender);
 
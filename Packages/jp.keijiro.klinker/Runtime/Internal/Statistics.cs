@@ -0,0 +1,41 @@
+// Klinker - Blackmagic DeckLink plugin for Unity
+// https://github.com/keijiro/Klinker
+
+using System.Runtime.InteropServices;
+
+namespace Klinker
+{
+    // Statistics snapshot of a receiver/sender (times in microseconds)
+    // Should be kept in sync with klinker::Statistics.
+    [StructLayout(LayoutKind.Sequential)]
+    public struct Statistics
+    {
+        public long framesIn;
+        public long framesOut;
+
+        public long dropsNewest;
+        public long dropsOldest;
+        public long dropsSuperseded;
+        public long dropsOverqueue;
+        public long dropsUnderrun;
+        public long dropsOutput;
+        public long dropsFlushed;
+        public long dropsRecovery;
+        public long dropsPinned;
+
+        public long lateFrames;
+
+        public int queueDepthMin;
+        public int queueDepthMax;
+        public double queueDepthAvg;
+
+        public long bytesCopied;
+        public long copyTime;
+
+        public long callbackCount;
+        public long callbackTime;
+        public long callbackTimeMax;
+
+        public long lockWaitTime;
+    }
+}
@@ -0,0 +1,242 @@
+#pragma once
+
+#include "Common.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace klinker
+{
+    //
+    // Lock-free audio sample ring class
+    //
+    // A single-producer/single-consumer ring buffer of interleaved samples.
+    // Samples are stored in float, and integer PCM samples are converted on
+    // writing/reading, so the two sides can use different sample types.
+    //
+    // Writes are all-or-nothing: A packet is discarded (and counted as an
+    // overrun) when there is no room for it. This keeps the sample stream
+    // continuous between time marks.
+    //
+    // A write can carry a time mark (the stream time of its first sample in
+    // flicks). The reader gets the stream time of the samples it reads,
+    // extrapolated from the last mark with the sample rate.
+    //
+    // No heap allocation happens after Reset.
+    //
+    class AudioRing final
+    {
+    public:
+
+        static const std::int64_t noTime = INT64_MIN;
+
+        #pragma region Accessor methods
+
+        // Not thread safe: Should be called only while stopped.
+        // The capacity is rounded up to a power of two.
+        void Reset(int channelCount, std::size_t capacity, int sampleRate)
+        {
+            std::size_t rounded = 1;
+            while (rounded < capacity) rounded <<= 1;
+
+            channelCount_ = channelCount;
+            capacity_ = channelCount > 0 ? rounded : 0;
+            sampleRate_ = sampleRate;
+            buffer_.reset(capacity_ > 0 ? new float[capacity_ * channelCount] : nullptr);
+
+            read_ = write_ = 0;
+            markHead_ = markTail_ = 0;
+            overruns_ = 0;
+        }
+
+        int GetChannelCount() const
+        {
+            return channelCount_;
+        }
+
+        // Number of the sample frames available for reading
+        std::size_t CountReadable() const
+        {
+            auto read = read_.load();
+            return static_cast<std::size_t>(write_.load() - read);
+        }
+
+        // Number of the packets discarded on writing
+        std::int64_t CountOverruns() const
+        {
+            return overruns_.load();
+        }
+
+        #pragma endregion
+
+        #pragma region Producer side methods
+
+        // Write sample frames. Returns false when there is no room for them.
+        template <typename S>
+        bool Write(const S* source, std::size_t frameCount, std::int64_t time = noTime)
+        {
+            if (capacity_ == 0) return false;
+
+            auto write = write_.load(std::memory_order_relaxed);
+            if (capacity_ - (write - read_.load()) < frameCount)
+            {
+                overruns_++;
+                return false;
+            }
+
+            if (time != noTime) PushMark(write, time);
+
+            // Two segments (before/after wrapping around)
+            auto offset = static_cast<std::size_t>(write & (capacity_ - 1));
+            auto first = std::min(frameCount, capacity_ - offset);
+            Convert(source, buffer_.get() + offset * channelCount_, first * channelCount_);
+            Convert(source + first * channelCount_, buffer_.get(), (frameCount - first) * channelCount_);
+
+            write_.store(write + frameCount);
+            return true;
+        }
+
+        #pragma endregion
+
+        #pragma region Consumer side methods
+
+        // Read sample frames. Returns the number of the frames read. The
+        // stream time of the first frame is stored in time (noTime if it's
+        // unknown).
+        template <typename S>
+        std::size_t Read(S* dest, std::size_t frameCount, std::int64_t* time = nullptr)
+        {
+            if (capacity_ == 0) return 0;
+
+            auto read = read_.load(std::memory_order_relaxed);
+            auto count = std::min<std::size_t>(frameCount, write_.load() - read);
+
+            auto t = GetTimeAt(read);
+            if (time != nullptr) *time = count > 0 ? t : noTime;
+
+            auto offset = static_cast<std::size_t>(read & (capacity_ - 1));
+            auto first = std::min(count, capacity_ - offset);
+            Convert(buffer_.get() + offset * channelCount_, dest, first * channelCount_);
+            Convert(buffer_.get(), dest + first * channelCount_, (count - first) * channelCount_);
+
+            read_.store(read + count);
+            return count;
+        }
+
+        // Discard sample frames without reading.
+        std::size_t Skip(std::size_t frameCount)
+        {
+            auto read = read_.load(std::memory_order_relaxed);
+            auto count = std::min<std::size_t>(frameCount, write_.load() - read);
+            read_.store(read + count);
+            GetTimeAt(read + count); // Drop the stale marks.
+            return count;
+        }
+
+        #pragma endregion
+
+    private:
+
+        #pragma region Sample conversion
+
+        static float ToFloat(float x) { return x; }
+        static float ToFloat(std::int16_t x) { return x * (1.0f / 32768); }
+        static float ToFloat(std::int32_t x) { return x * (1.0f / 2147483648.0f); }
+
+        static void FromFloat(float x, float& out)
+        {
+            out = x;
+        }
+
+        static void FromFloat(float x, std::int16_t& out)
+        {
+            auto s = std::min(std::max(x * 32768.0f, -32768.0f), 32767.0f);
+            out = static_cast<std::int16_t>(s);
+        }
+
+        static void FromFloat(float x, std::int32_t& out)
+        {
+            auto s = std::min(std::max(x * 2147483648.0, -2147483648.0), 2147483647.0);
+            out = static_cast<std::int32_t>(s);
+        }
+
+        template <typename S>
+        static void Convert(const S* source, float* dest, std::size_t count)
+        {
+            for (std::size_t i = 0; i < count; i++) dest[i] = ToFloat(source[i]);
+        }
+
+        template <typename S>
+        static void Convert(const float* source, S* dest, std::size_t count)
+        {
+            for (std::size_t i = 0; i < count; i++) FromFloat(source[i], dest[i]);
+        }
+
+        static void Convert(const float* source, float* dest, std::size_t count)
+        {
+            std::copy(source, source + count, dest);
+        }
+
+        #pragma endregion
+
+        #pragma region Time marks
+
+        struct Mark
+        {
+            std::uint64_t frame;
+            std::int64_t time;
+        };
+
+        static const std::size_t markCount_ = 256;
+
+        // Producer side: A mark is simply omitted when the mark ring is full;
+        // The time will be extrapolated from the previous one.
+        void PushMark(std::uint64_t frame, std::int64_t time)
+        {
+            auto tail = markTail_.load(std::memory_order_relaxed);
+            if (tail - markHead_.load() >= markCount_) return;
+            marks_[tail % markCount_] = { frame, time };
+            markTail_.store(tail + 1);
+        }
+
+        // Consumer side: Find the last mark at or before a given frame and
+        // extrapolate the time. Older marks are discarded.
+        std::int64_t GetTimeAt(std::uint64_t frame)
+        {
+            auto head = markHead_.load(std::memory_order_relaxed);
+            auto tail = markTail_.load();
+
+            if (head == tail) return noTime;
+
+            while (head + 1 < tail && marks_[(head + 1) % markCount_].frame <= frame) head++;
+            markHead_.store(head);
+
+            const auto& mark = marks_[head % markCount_];
+            if (mark.frame > frame) return noTime;
+
+            auto delta = static_cast<std::int64_t>(frame - mark.frame);
+            return mark.time + delta * flicksPerSecond / sampleRate_;
+        }
+
+        #pragma endregion
+
+        #pragma region Private members
+
+        int channelCount_ = 0;
+        std::size_t capacity_ = 0; // in frames
+        int sampleRate_ = 48000;
+        std::unique_ptr<float[]> buffer_;
+
+        // Monotonic frame counters
+        std::atomic<std::uint64_t> read_ = 0;
+        std::atomic<std::uint64_t> write_ = 0;
+
+        Mark marks_[markCount_];
+        std::atomic<std::uint64_t> markHead_ = 0;
+        std::atomic<std::uint64_t> markTail_ = 0;
+
+        std::atomic<std::int64_t> overruns_ = 0;
+
+        #pragma endregion
+    };
+}
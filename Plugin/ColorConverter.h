@@ -0,0 +1,442 @@
+#pragma once
+
+#include "CpuFeatures.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cstring>
+#include <immintrin.h>
+
+namespace klinker
+{
+    //
+    // Output pixel formats of the color converter
+    //
+    enum class ConvertFormat : int
+    {
+        RGBA8,   // 8-bit RGBA
+        BGRA8,   // 8-bit BGRA
+        RGBAHalf // Half-precision RGBA
+    };
+
+    //
+    // Field selection modes
+    //
+    enum class FieldMode : int
+    {
+        Progressive, // Convert all the lines as they are.
+        OddField,    // Line-double the odd field (lines 0, 2, 4...).
+        EvenField    // Line-double the even field (lines 1, 3, 5...).
+    };
+
+    //
+    // Color converter class
+    //
+    // Converts UYVY frames into RGB formats on the CPU. It's an alternative
+    // to the upsampler shader for headless receivers and CPU consumers, so
+    // the math (Rec.709 limited range) and the deinterlacing pattern are
+    // identical to the ones in Upsampler.cginc.
+    //
+    // 8-bit outputs are clamped and stored in gamma space. Half-precision
+    // output can be converted into linear space (same approximation as
+    // GammaToLinearSpace).
+    //
+    // A frame is split into row bands and processed on a thread pool. Each
+    // row is converted with an AVX2/SSE4.1 kernel selected at run time.
+    //
+    class ColorConverter final
+    {
+    public:
+
+        #pragma region Constructor/destructor
+
+        // Zero or less selects the number of the hardware threads.
+        ColorConverter(int threadCount = 0)
+          : pool_(threadCount)
+        {
+        }
+
+        #pragma endregion
+
+        #pragma region Public methods
+
+        static std::size_t GetBytesPerPixel(ConvertFormat format)
+        {
+            return format == ConvertFormat::RGBAHalf ? 8 : 4;
+        }
+
+        void Convert(
+            const void* source, std::size_t sourceRowBytes,
+            void* dest, std::size_t destRowBytes,
+            int width, int height,
+            ConvertFormat format, FieldMode field, bool linear
+        )
+        {
+            Job job;
+            job.source = static_cast<const std::uint8_t*>(source);
+            job.sourceRowBytes = sourceRowBytes;
+            job.dest = static_cast<std::uint8_t*>(dest);
+            job.destRowBytes = destRowBytes;
+            job.width = width;
+            job.height = height;
+            job.format = format;
+            job.field = field;
+            job.linear = linear;
+            job.kernel = SelectKernel();
+
+            // Row band split (a few bands per thread for load balancing)
+            auto bands = std::min(height, pool_.GetThreadCount() * 2);
+            if (bands <= 0) return;
+            job.bandHeight = (height + bands - 1) / bands;
+
+            pool_.Run(bands, ConvertBand, &job);
+        }
+
+        #pragma endregion
+
+    private:
+
+        #pragma region Job dispatching
+
+        using RowKernel = void (*)(
+            const std::uint8_t*, std::uint8_t*, int, ConvertFormat, bool
+        );
+
+        struct Job
+        {
+            const std::uint8_t* source;
+            std::size_t sourceRowBytes;
+            std::uint8_t* dest;
+            std::size_t destRowBytes;
+            int width, height, bandHeight;
+            ConvertFormat format;
+            FieldMode field;
+            bool linear;
+            RowKernel kernel;
+        };
+
+        ThreadPool pool_;
+
+        static RowKernel SelectKernel()
+        {
+            if (CpuFeatures::HasAVX2()) return ConvertRowAVX2;
+            if (CpuFeatures::HasSSE41()) return ConvertRowSSE41;
+            return ConvertRowScalar;
+        }
+
+        static int GetSourceRow(int y, FieldMode field)
+        {
+            if (field == FieldMode::OddField) return y / 2 * 2;
+            if (field == FieldMode::EvenField) return std::max(0, (y + 1) / 2 * 2 - 1);
+            return y;
+        }
+
+        static void ConvertBand(void* context, int index)
+        {
+            auto& job = *static_cast<Job*>(context);
+
+            auto y0 = index * job.bandHeight;
+            auto y1 = std::min(y0 + job.bandHeight, job.height);
+
+            for (auto y = y0; y < y1; y++)
+            {
+                auto sy = GetSourceRow(y, job.field);
+                job.kernel(
+                    job.source + job.sourceRowBytes * sy,
+                    job.dest + job.destRowBytes * y,
+                    job.width, job.format, job.linear
+                );
+            }
+        }
+
+        #pragma endregion
+
+        #pragma region Scalar implementation
+
+        // Rec.709 coefficients (same as Upsampler.cginc)
+        static float K_R() { return 0.2126f; }
+        static float K_B() { return 0.0722f; }
+
+        static void YUV2RGB(int y, int u, int v, float& r, float& g, float& b)
+        {
+            auto fy = static_cast<float>(y - 16) * (1.0f / 219);
+            auto fu = static_cast<float>(u - 128) * (1.0f / 112);
+            auto fv = static_cast<float>(v - 128) * (1.0f / 112);
+
+            r = fy + fv * (1 - K_R());
+            g = fy - fv * (K_R() / (1 - K_R())) - fu * (K_B() / (1 - K_B()));
+            b = fy + fu * (1 - K_B());
+        }
+
+        static std::uint8_t ToUNorm8(float c)
+        {
+            c = std::min(std::max(c, 0.0f), 1.0f);
+            return static_cast<std::uint8_t>(c * 255 + 0.5f);
+        }
+
+        // Float -> half conversion with round-half-up
+        // Denormals are flushed to zero. The SIMD kernels use the exactly
+        // same arithmetic.
+        static std::uint16_t ToHalf(float c, bool linear)
+        {
+            c = std::max(c, 0.0f);
+            if (linear) c = c * (c * (c * 0.305306011f + 0.682171111f) + 0.012522878f);
+            if (c < 6.103515625e-5f) return 0;
+            std::uint32_t bits;
+            std::memcpy(&bits, &c, sizeof(bits));
+            return static_cast<std::uint16_t>(((bits + 0x1000) >> 13) - 0x1c000);
+        }
+
+        static void StorePixel(
+            std::uint8_t* dst, int y, int u, int v,
+            ConvertFormat format, bool linear
+        )
+        {
+            float r, g, b;
+            YUV2RGB(y, u, v, r, g, b);
+
+            if (format == ConvertFormat::RGBAHalf)
+            {
+                auto p = reinterpret_cast<std::uint16_t*>(dst);
+                p[0] = ToHalf(r, linear);
+                p[1] = ToHalf(g, linear);
+                p[2] = ToHalf(b, linear);
+                p[3] = 0x3c00; // 1.0
+            }
+            else
+            {
+                if (format == ConvertFormat::BGRA8) std::swap(r, b);
+                dst[0] = ToUNorm8(r);
+                dst[1] = ToUNorm8(g);
+                dst[2] = ToUNorm8(b);
+                dst[3] = 0xff;
+            }
+        }
+
+        static void ConvertRowScalar(
+            const std::uint8_t* src, std::uint8_t* dst, int width,
+            ConvertFormat format, bool linear
+        )
+        {
+            auto bpp = GetBytesPerPixel(format);
+
+            for (auto x = 0; x < width; x += 2, src += 4, dst += bpp * 2)
+            {
+                StorePixel(dst,       src[1], src[0], src[2], format, linear);
+                StorePixel(dst + bpp, src[3], src[0], src[2], format, linear);
+            }
+        }
+
+        #pragma endregion
+
+        #pragma region SSE4.1 implementation
+
+        static void YUV2RGB(__m128i y, __m128i u, __m128i v, __m128& r, __m128& g, __m128& b)
+        {
+            auto fy = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(y, _mm_set1_epi32( 16))), _mm_set1_ps(1.0f / 219));
+            auto fu = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(u, _mm_set1_epi32(128))), _mm_set1_ps(1.0f / 112));
+            auto fv = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(v, _mm_set1_epi32(128))), _mm_set1_ps(1.0f / 112));
+
+            r = _mm_add_ps(fy, _mm_mul_ps(fv, _mm_set1_ps(1 - K_R())));
+            g = _mm_sub_ps(
+                _mm_sub_ps(fy, _mm_mul_ps(fv, _mm_set1_ps(K_R() / (1 - K_R())))),
+                _mm_mul_ps(fu, _mm_set1_ps(K_B() / (1 - K_B())))
+            );
+            b = _mm_add_ps(fy, _mm_mul_ps(fu, _mm_set1_ps(1 - K_B())));
+        }
+
+        static __m128i ToUNorm8(__m128 c)
+        {
+            c = _mm_min_ps(_mm_max_ps(c, _mm_setzero_ps()), _mm_set1_ps(1));
+            c = _mm_add_ps(_mm_mul_ps(c, _mm_set1_ps(255)), _mm_set1_ps(0.5f));
+            return _mm_cvttps_epi32(c);
+        }
+
+        static __m128i ToHalf(__m128 c, bool linear)
+        {
+            c = _mm_max_ps(c, _mm_setzero_ps());
+
+            if (linear)
+            {
+                auto t = _mm_add_ps(_mm_mul_ps(c, _mm_set1_ps(0.305306011f)), _mm_set1_ps(0.682171111f));
+                t = _mm_add_ps(_mm_mul_ps(c, t), _mm_set1_ps(0.012522878f));
+                c = _mm_mul_ps(c, t);
+            }
+
+            auto h = _mm_add_epi32(_mm_castps_si128(c), _mm_set1_epi32(0x1000));
+            h = _mm_sub_epi32(_mm_srli_epi32(h, 13), _mm_set1_epi32(0x1c000));
+            return _mm_andnot_si128(_mm_castps_si128(_mm_cmplt_ps(c, _mm_set1_ps(6.103515625e-5f))), h);
+        }
+
+        // Store four pixels.
+        static void StorePixels(
+            std::uint8_t* dst, __m128 r, __m128 g, __m128 b,
+            ConvertFormat format, bool linear
+        )
+        {
+            if (format == ConvertFormat::RGBAHalf)
+            {
+                auto rg = _mm_or_si128(ToHalf(r, linear), _mm_slli_epi32(ToHalf(g, linear), 16));
+                auto ba = _mm_or_si128(ToHalf(b, linear), _mm_set1_epi32(0x3c000000));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst +  0), _mm_unpacklo_epi32(rg, ba));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16), _mm_unpackhi_epi32(rg, ba));
+            }
+            else
+            {
+                if (format == ConvertFormat::BGRA8) std::swap(r, b);
+                auto p = _mm_or_si128(ToUNorm8(r), _mm_slli_epi32(ToUNorm8(g), 8));
+                p = _mm_or_si128(p, _mm_slli_epi32(ToUNorm8(b), 16));
+                p = _mm_or_si128(p, _mm_set1_epi32(static_cast<int>(0xff000000U)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), p);
+            }
+        }
+
+        // Byte shuffle tables for extracting samples into 32-bit lanes
+        #define KLINKER_UYVY_SHUFFLE_Y(o) o+1,-1,-1,-1, o+3,-1,-1,-1, o+5,-1,-1,-1, o+7,-1,-1,-1
+        #define KLINKER_UYVY_SHUFFLE_U(o) o+0,-1,-1,-1, o+0,-1,-1,-1, o+4,-1,-1,-1, o+4,-1,-1,-1
+        #define KLINKER_UYVY_SHUFFLE_V(o) o+2,-1,-1,-1, o+2,-1,-1,-1, o+6,-1,-1,-1, o+6,-1,-1,-1
+
+        static void ConvertRowSSE41(
+            const std::uint8_t* src, std::uint8_t* dst, int width,
+            ConvertFormat format, bool linear
+        )
+        {
+            const auto shY = _mm_setr_epi8(KLINKER_UYVY_SHUFFLE_Y(0));
+            const auto shU = _mm_setr_epi8(KLINKER_UYVY_SHUFFLE_U(0));
+            const auto shV = _mm_setr_epi8(KLINKER_UYVY_SHUFFLE_V(0));
+
+            auto bpp = GetBytesPerPixel(format);
+            auto count = width / 4;
+
+            // Four pixels (8 bytes) per iteration
+            for (auto i = 0; i < count; i++, src += 8, dst += bpp * 4)
+            {
+                auto raw = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src));
+
+                __m128 r, g, b;
+                YUV2RGB(
+                    _mm_shuffle_epi8(raw, shY),
+                    _mm_shuffle_epi8(raw, shU),
+                    _mm_shuffle_epi8(raw, shV),
+                    r, g, b
+                );
+
+                StorePixels(dst, r, g, b, format, linear);
+            }
+
+            // Remaining pixels
+            ConvertRowScalar(src, dst, width - count * 4, format, linear);
+        }
+
+        #pragma endregion
+
+        #pragma region AVX2 implementation
+
+        static void YUV2RGB(__m256i y, __m256i u, __m256i v, __m256& r, __m256& g, __m256& b)
+        {
+            auto fy = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(y, _mm256_set1_epi32( 16))), _mm256_set1_ps(1.0f / 219));
+            auto fu = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(u, _mm256_set1_epi32(128))), _mm256_set1_ps(1.0f / 112));
+            auto fv = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_sub_epi32(v, _mm256_set1_epi32(128))), _mm256_set1_ps(1.0f / 112));
+
+            r = _mm256_add_ps(fy, _mm256_mul_ps(fv, _mm256_set1_ps(1 - K_R())));
+            g = _mm256_sub_ps(
+                _mm256_sub_ps(fy, _mm256_mul_ps(fv, _mm256_set1_ps(K_R() / (1 - K_R())))),
+                _mm256_mul_ps(fu, _mm256_set1_ps(K_B() / (1 - K_B())))
+            );
+            b = _mm256_add_ps(fy, _mm256_mul_ps(fu, _mm256_set1_ps(1 - K_B())));
+        }
+
+        static __m256i ToUNorm8(__m256 c)
+        {
+            c = _mm256_min_ps(_mm256_max_ps(c, _mm256_setzero_ps()), _mm256_set1_ps(1));
+            c = _mm256_add_ps(_mm256_mul_ps(c, _mm256_set1_ps(255)), _mm256_set1_ps(0.5f));
+            return _mm256_cvttps_epi32(c);
+        }
+
+        static __m256i ToHalf(__m256 c, bool linear)
+        {
+            c = _mm256_max_ps(c, _mm256_setzero_ps());
+
+            if (linear)
+            {
+                auto t = _mm256_add_ps(_mm256_mul_ps(c, _mm256_set1_ps(0.305306011f)), _mm256_set1_ps(0.682171111f));
+                t = _mm256_add_ps(_mm256_mul_ps(c, t), _mm256_set1_ps(0.012522878f));
+                c = _mm256_mul_ps(c, t);
+            }
+
+            auto h = _mm256_add_epi32(_mm256_castps_si256(c), _mm256_set1_epi32(0x1000));
+            h = _mm256_sub_epi32(_mm256_srli_epi32(h, 13), _mm256_set1_epi32(0x1c000));
+            auto denormal = _mm256_cmp_ps(c, _mm256_set1_ps(6.103515625e-5f), _CMP_LT_OQ);
+            return _mm256_andnot_si256(_mm256_castps_si256(denormal), h);
+        }
+
+        // Store eight pixels.
+        static void StorePixels(
+            std::uint8_t* dst, __m256 r, __m256 g, __m256 b,
+            ConvertFormat format, bool linear
+        )
+        {
+            if (format == ConvertFormat::RGBAHalf)
+            {
+                auto rg = _mm256_or_si256(ToHalf(r, linear), _mm256_slli_epi32(ToHalf(g, linear), 16));
+                auto ba = _mm256_or_si256(ToHalf(b, linear), _mm256_set1_epi32(0x3c000000));
+
+                // Interleaving is done per lane: (0 1 | 4 5), (2 3 | 6 7)
+                auto lo = _mm256_unpacklo_epi32(rg, ba);
+                auto hi = _mm256_unpackhi_epi32(rg, ba);
+
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst +  0), _mm256_permute2x128_si256(lo, hi, 0x20));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 32), _mm256_permute2x128_si256(lo, hi, 0x31));
+            }
+            else
+            {
+                if (format == ConvertFormat::BGRA8) std::swap(r, b);
+                auto p = _mm256_or_si256(ToUNorm8(r), _mm256_slli_epi32(ToUNorm8(g), 8));
+                p = _mm256_or_si256(p, _mm256_slli_epi32(ToUNorm8(b), 16));
+                p = _mm256_or_si256(p, _mm256_set1_epi32(static_cast<int>(0xff000000U)));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), p);
+            }
+        }
+
+        static void ConvertRowAVX2(
+            const std::uint8_t* src, std::uint8_t* dst, int width,
+            ConvertFormat format, bool linear
+        )
+        {
+            // The lower lane takes the first four pixels, and the upper lane
+            // takes the rest.
+            const auto shY = _mm256_setr_epi8(KLINKER_UYVY_SHUFFLE_Y(0), KLINKER_UYVY_SHUFFLE_Y(8));
+            const auto shU = _mm256_setr_epi8(KLINKER_UYVY_SHUFFLE_U(0), KLINKER_UYVY_SHUFFLE_U(8));
+            const auto shV = _mm256_setr_epi8(KLINKER_UYVY_SHUFFLE_V(0), KLINKER_UYVY_SHUFFLE_V(8));
+
+            auto bpp = GetBytesPerPixel(format);
+            auto count = width / 8;
+
+            // Eight pixels (16 bytes) per iteration
+            for (auto i = 0; i < count; i++, src += 16, dst += bpp * 8)
+            {
+                auto raw = _mm256_broadcastsi128_si256(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(src))
+                );
+
+                __m256 r, g, b;
+                YUV2RGB(
+                    _mm256_shuffle_epi8(raw, shY),
+                    _mm256_shuffle_epi8(raw, shU),
+                    _mm256_shuffle_epi8(raw, shV),
+                    r, g, b
+                );
+
+                StorePixels(dst, r, g, b, format, linear);
+            }
+
+            // Remaining pixels
+            ConvertRowSSE41(src, dst, width - count * 8, format, linear);
+        }
+
+        #undef KLINKER_UYVY_SHUFFLE_Y
+        #undef KLINKER_UYVY_SHUFFLE_U
+        #undef KLINKER_UYVY_SHUFFLE_V
+
+        #pragma endregion
+    };
+}
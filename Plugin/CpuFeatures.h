@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Common.h"
+#include <intrin.h>
+
+namespace klinker
+{
+    //
+    // CPU feature detection
+    //
+    // Used to select SIMD kernels at run time. The detection is done only
+    // once on the first query.
+    //
+    class CpuFeatures final
+    {
+    public:
+
+        static bool HasSSE41()
+        {
+            return GetInstance().sse41_;
+        }
+
+        static bool HasAVX2()
+        {
+            return GetInstance().avx2_;
+        }
+
+    private:
+
+        bool sse41_ = false;
+        bool avx2_ = false;
+
+        CpuFeatures()
+        {
+            int regs[4];
+
+            __cpuid(regs, 0);
+            auto maxLeaf = regs[0];
+
+            __cpuid(regs, 1);
+            sse41_ = (regs[2] & (1 << 19)) != 0;
+
+            // AVX2 requires the OS support of the YMM state (OSXSAVE).
+            auto osxsave = (regs[2] & (1 << 27)) != 0;
+            auto ymmState = osxsave && (_xgetbv(0) & 6) == 6;
+
+            if (maxLeaf >= 7 && ymmState)
+            {
+                __cpuidex(regs, 7, 0);
+                avx2_ = (regs[1] & (1 << 5)) != 0;
+            }
+        }
+
+        static const CpuFeatures& GetInstance()
+        {
+            static CpuFeatures instance;
+            return instance;
+        }
+    };
+}
@@ -0,0 +1,394 @@
+#pragma once
+
+#include "Common.h"
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace klinker
+{
+    //
+    // Display mode information
+    //
+    struct DisplayModeInfo
+    {
+        BMDDisplayMode mode = bmdModeUnknown;
+        int width = 0;
+        int height = 0;
+        BMDTimeValue frameDuration = 0;
+        BMDTimeScale timeScale = 1;
+        BMDFieldDominance fieldDominance = bmdUnknownFieldDominance;
+        std::uint32_t pixelFormats = 0; // Bit n: DisplayModeInfo::GetPixelFormat(n)
+        BSTR name = nullptr;
+
+        // Pixel formats probed on catalog building
+        static const int pixelFormatCount = 9;
+
+        static BMDPixelFormat GetPixelFormat(int index)
+        {
+            static const BMDPixelFormat formats[pixelFormatCount] =
+            {
+                bmdFormat8BitYUV, bmdFormat10BitYUV,
+                bmdFormat8BitARGB, bmdFormat8BitBGRA,
+                bmdFormat10BitRGB, bmdFormat12BitRGB, bmdFormat12BitRGBLE,
+                bmdFormat10BitRGBXLE, bmdFormat10BitRGBX
+            };
+            return formats[index];
+        }
+    };
+
+    //
+    // Device information
+    //
+    struct DeviceInfo
+    {
+        IDeckLink* device = nullptr;
+        BSTR name = nullptr;
+        std::int64_t persistentID = 0;  // Zero: not available
+        std::int64_t topologicalID = 0; // Zero: not available
+        std::vector<DisplayModeInfo> inputModes;  // In the iterator order
+        std::vector<DisplayModeInfo> outputModes; // In the iterator order
+    };
+
+    //
+    // Device selection (result of resolving a device/mode specifier)
+    //
+    struct DeviceSelection
+    {
+        IDeckLink* device = nullptr; // AddRef-ed; nullptr on failure
+        BMDDisplayMode mode = bmdModeUnknown;
+        const char* error = nullptr;
+    };
+
+    //
+    // Device catalog class
+    //
+    // A process-wide cache of the devices and their display modes. It's
+    // built on the first access and rebuilt only when a device arrives or
+    // is removed (IDeckLinkDiscovery notifications), so enumerations and
+    // device opens don't walk the devices every time.
+    //
+    // The devices and modes are kept in the iterator order, so the indices
+    // are compatible with the plain IDeckLinkIterator enumeration. Devices
+    // can also be looked up by their persistent/topological IDs, which are
+    // stable across hotplugging. Strings in the catalog are valid until the
+    // next rebuild.
+    //
+    class DeviceCatalog final : private IDeckLinkDeviceNotificationCallback
+    {
+    public:
+
+        #pragma region Singleton accessor
+
+        static DeviceCatalog& GetInstance()
+        {
+            // Intentionally leaked: The COM objects shouldn't be released on
+            // unloading the DLL.
+            static auto instance = new DeviceCatalog();
+            return *instance;
+        }
+
+        #pragma endregion
+
+        #pragma region Accessor methods
+
+        // Call a function with the device list. The list is rebuilt in
+        // advance if it's outdated.
+        template <typename F>
+        void Access(F function)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (dirty_.exchange(false)) Rebuild();
+            function(static_cast<const std::vector<DeviceInfo>&>(devices_));
+        }
+
+        #pragma endregion
+
+        #pragma region Device selection methods
+
+        // Select a device and its n-th input/output display mode by indices.
+        DeviceSelection SelectInput(int deviceIndex, int modeIndex)
+        {
+            return SelectByIndex(deviceIndex, modeIndex, &DeviceInfo::inputModes);
+        }
+
+        DeviceSelection SelectOutput(int deviceIndex, int modeIndex)
+        {
+            return SelectByIndex(deviceIndex, modeIndex, &DeviceInfo::outputModes);
+        }
+
+        // Select a device by its persistent ID or topological ID (the
+        // persistent ID takes priority). The display mode code (FourCC) is
+        // passed through; It's validated on opening the device.
+        DeviceSelection SelectByID(std::int64_t deviceID, std::uint32_t modeCode)
+        {
+            DeviceSelection selection;
+            selection.mode = static_cast<BMDDisplayMode>(modeCode);
+
+            Access([&](const std::vector<DeviceInfo>& devices)
+            {
+                if (!driverAvailable_)
+                {
+                    selection.error = "DeckLink driver is not found.";
+                    return;
+                }
+
+                auto index = FindDeviceByID(deviceID);
+
+                if (index < 0)
+                {
+                    selection.error = "Device is not found.";
+                    return;
+                }
+
+                selection.device = devices[index].device;
+                selection.device->AddRef();
+            });
+
+            return selection;
+        }
+
+        #pragma endregion
+
+        #pragma region IUnknown implementation
+
+        HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, LPVOID* ppv) override
+        {
+            if (iid == IID_IUnknown || iid == IID_IDeckLinkDeviceNotificationCallback)
+            {
+                *ppv = this;
+                return S_OK;
+            }
+
+            *ppv = nullptr;
+            return E_NOINTERFACE;
+        }
+
+        // The singleton is never destroyed, so no reference counting.
+        ULONG STDMETHODCALLTYPE AddRef() override { return 1; }
+        ULONG STDMETHODCALLTYPE Release() override { return 1; }
+
+        #pragma endregion
+
+        #pragma region IDeckLinkDeviceNotificationCallback implementation
+
+        // These are called on a driver thread. The catalog is only marked
+        // as outdated here and rebuilt on the next access.
+
+        HRESULT STDMETHODCALLTYPE DeckLinkDeviceArrived(IDeckLink* device) override
+        {
+            DebugLog("DeckLink device arrived.");
+            dirty_ = true;
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE DeckLinkDeviceRemoved(IDeckLink* device) override
+        {
+            DebugLog("DeckLink device removed.");
+            dirty_ = true;
+            return S_OK;
+        }
+
+        #pragma endregion
+
+    private:
+
+        #pragma region Private members
+
+        std::mutex mutex_;
+        std::atomic<bool> dirty_ = true;
+        std::vector<DeviceInfo> devices_;
+        bool driverAvailable_ = false;
+        IDeckLinkDiscovery* discovery_ = nullptr;
+
+        DeviceCatalog()
+        {
+            // Hotplug notifications (not essential; The catalog is built
+            // on the first access anyway)
+            auto res = CoCreateInstance(
+                CLSID_CDeckLinkDiscovery, nullptr, CLSCTX_ALL,
+                IID_IDeckLinkDiscovery, reinterpret_cast<void**>(&discovery_)
+            );
+
+            if (res == S_OK)
+                ShouldOK(discovery_->InstallDeviceNotifications(this));
+            else
+                discovery_ = nullptr;
+        }
+
+        std::unordered_map<std::int64_t, std::size_t> persistentIDMap_;
+        std::unordered_map<std::int64_t, std::size_t> topologicalIDMap_;
+
+        int FindDeviceByID(std::int64_t deviceID) const
+        {
+            if (deviceID == 0) return -1;
+
+            auto it = persistentIDMap_.find(deviceID);
+            if (it != persistentIDMap_.end()) return static_cast<int>(it->second);
+
+            it = topologicalIDMap_.find(deviceID);
+            if (it != topologicalIDMap_.end()) return static_cast<int>(it->second);
+
+            return -1;
+        }
+
+        DeviceSelection SelectByIndex(int deviceIndex, int modeIndex, std::vector<DisplayModeInfo> DeviceInfo::* list)
+        {
+            DeviceSelection selection;
+
+            Access([&](const std::vector<DeviceInfo>& devices)
+            {
+                if (!driverAvailable_)
+                {
+                    selection.error = "DeckLink driver is not found.";
+                    return;
+                }
+
+                if (deviceIndex < 0 || deviceIndex >= static_cast<int>(devices.size()))
+                {
+                    selection.error = "Invalid device index.";
+                    return;
+                }
+
+                const auto& modes = devices[deviceIndex].*list;
+
+                if (modeIndex < 0 || modeIndex >= static_cast<int>(modes.size()))
+                {
+                    selection.error = "Invalid format index.";
+                    return;
+                }
+
+                selection.device = devices[deviceIndex].device;
+                selection.device->AddRef();
+                selection.mode = modes[modeIndex].mode;
+            });
+
+            return selection;
+        }
+
+        #pragma endregion
+
+        #pragma region Catalog building
+
+        void Clear()
+        {
+            for (auto& info : devices_)
+            {
+                for (auto& mode : info.inputModes) SysFreeString(mode.name);
+                for (auto& mode : info.outputModes) SysFreeString(mode.name);
+                SysFreeString(info.name);
+                info.device->Release();
+            }
+            devices_.clear();
+            persistentIDMap_.clear();
+            topologicalIDMap_.clear();
+        }
+
+        void Rebuild()
+        {
+            Clear();
+
+            // Device iterator
+            IDeckLinkIterator* iterator;
+            auto res = CoCreateInstance(
+                CLSID_CDeckLinkIterator, nullptr, CLSCTX_ALL,
+                IID_IDeckLinkIterator, reinterpret_cast<void**>(&iterator)
+            );
+
+            // If the driver is not found, leave the list empty.
+            driverAvailable_ = (res == S_OK);
+            if (!driverAvailable_) return;
+
+            IDeckLink* device;
+            while (iterator->Next(&device) == S_OK)
+            {
+                DeviceInfo info;
+                info.device = device; // The reference is moved to the catalog.
+                ShouldOK(device->GetDisplayName(&info.name));
+
+                // Device IDs
+                IDeckLinkAttributes* attributes;
+                if (device->QueryInterface(IID_IDeckLinkAttributes, reinterpret_cast<void**>(&attributes)) == S_OK)
+                {
+                    LONGLONG value;
+                    if (attributes->GetInt(BMDDeckLinkPersistentID, &value) == S_OK) info.persistentID = value;
+                    if (attributes->GetInt(BMDDeckLinkTopologicalID, &value) == S_OK) info.topologicalID = value;
+                    attributes->Release();
+                }
+
+                // Input modes
+                IDeckLinkInput* input;
+                if (device->QueryInterface(IID_IDeckLinkInput, reinterpret_cast<void**>(&input)) == S_OK)
+                {
+                    ScanModes(input, bmdVideoInputFlagDefault, info.inputModes);
+                    input->Release();
+                }
+
+                // Output modes
+                IDeckLinkOutput* output;
+                if (device->QueryInterface(IID_IDeckLinkOutput, reinterpret_cast<void**>(&output)) == S_OK)
+                {
+                    ScanModes(output, bmdVideoOutputFlagDefault, info.outputModes);
+                    output->Release();
+                }
+
+                // ID lookup tables
+                if (info.persistentID != 0) persistentIDMap_[info.persistentID] = devices_.size();
+                if (info.topologicalID != 0) topologicalIDMap_[info.topologicalID] = devices_.size();
+
+                devices_.push_back(std::move(info));
+            }
+
+            iterator->Release();
+        }
+
+        // T: IDeckLinkInput or IDeckLinkOutput
+        template <typename T, typename Flags>
+        static void ScanModes(T* io, Flags flags, std::vector<DisplayModeInfo>& modes)
+        {
+            IDeckLinkDisplayModeIterator* iterator;
+            if (io->GetDisplayModeIterator(&iterator) != S_OK) return;
+
+            IDeckLinkDisplayMode* mode;
+            while (iterator->Next(&mode) == S_OK)
+            {
+                DisplayModeInfo info;
+                info.mode = mode->GetDisplayMode();
+                info.width = mode->GetWidth();
+                info.height = mode->GetHeight();
+                info.fieldDominance = mode->GetFieldDominance();
+                info.pixelFormats = ProbePixelFormats(io, flags, info.mode);
+                ShouldOK(mode->GetFrameRate(&info.frameDuration, &info.timeScale));
+                ShouldOK(mode->GetName(&info.name));
+                modes.push_back(info);
+                mode->Release();
+            }
+
+            iterator->Release();
+        }
+
+        template <typename T, typename Flags>
+        static std::uint32_t ProbePixelFormats(T* io, Flags flags, BMDDisplayMode mode)
+        {
+            std::uint32_t mask = 0;
+
+            for (auto i = 0; i < DisplayModeInfo::pixelFormatCount; i++)
+            {
+                BMDDisplayModeSupport support;
+                IDeckLinkDisplayMode* result = nullptr;
+
+                auto res = io->DoesSupportVideoMode(
+                    mode, DisplayModeInfo::GetPixelFormat(i), flags, &support, &result
+                );
+
+                if (res == S_OK && support != bmdDisplayModeNotSupported) mask |= 1U << i;
+                if (result != nullptr) result->Release();
+            }
+
+            return mask;
+        }
+
+        #pragma endregion
+    };
+}
@@ -1,12 +1,36 @@
 #pragma once
 
-#include "Common.h"
+#include "DeviceCatalog.h"
 #include <algorithm>
 #include <vector>
 
 namespace klinker
 {
+    // Device IDs (zero: not available)
+    struct DeviceIDs
+    {
+        std::int64_t persistentID;
+        std::int64_t topologicalID;
+    };
+
+    // Display mode descriptor (plain data for the structured query)
+    struct DisplayModeDescriptor
+    {
+        std::uint32_t mode;                // BMDDisplayMode (FourCC)
+        std::int32_t width;
+        std::int32_t height;
+        std::uint32_t fieldDominance;      // BMDFieldDominance (FourCC)
+        std::int64_t frameDuration;        // in flicks
+        std::uint32_t inputPixelFormats;   // Zero: not available for input
+        std::uint32_t outputPixelFormats;  // Zero: not available for output
+    };
+
+    //
     // Device/format enumerator class
+    //
+    // Copies the names from the device catalog, so the returned strings
+    // stay valid until the next enumeration even if the catalog is rebuilt.
+    //
     class Enumerator final
     {
     public:
@@ -29,6 +53,54 @@ namespace klinker
             return count;
         }
 
+        // Copy the IDs of the devices (in the same order as the names).
+        static int CopyDeviceIDs(DeviceIDs ids[], int maxCount)
+        {
+            auto count = 0;
+
+            DeviceCatalog::GetInstance().Access([&](const std::vector<DeviceInfo>& devices)
+            {
+                count = std::min(maxCount, static_cast<int>(devices.size()));
+                for (auto i = 0; i < count; i++)
+                    ids[i] = { devices[i].persistentID, devices[i].topologicalID };
+            });
+
+            return count;
+        }
+
+        // Copy the display modes of a device into a descriptor array. The
+        // output modes come first (in the same order as the output format
+        // names), followed by the input-only modes. The pixel format masks
+        // are in the DisplayModeInfo::GetPixelFormat order.
+        static int CopyDisplayModes(int deviceIndex, DisplayModeDescriptor modes[], int maxCount)
+        {
+            auto count = 0;
+
+            DeviceCatalog::GetInstance().Access([&](const std::vector<DeviceInfo>& devices)
+            {
+                if (deviceIndex < 0 || deviceIndex >= static_cast<int>(devices.size())) return;
+                const auto& info = devices[deviceIndex];
+
+                for (const auto& m : info.outputModes)
+                {
+                    if (count == maxCount) return;
+                    auto& d = modes[count++] = ToDescriptor(m);
+                    d.outputPixelFormats = m.pixelFormats;
+                    d.inputPixelFormats = FindInputFormats(info, m.mode);
+                }
+
+                for (const auto& m : info.inputModes)
+                {
+                    if (count == maxCount) return;
+                    if (FindMode(info.outputModes, m.mode) != nullptr) continue;
+                    auto& d = modes[count++] = ToDescriptor(m);
+                    d.inputPixelFormats = m.pixelFormats;
+                }
+            });
+
+            return count;
+        }
+
         #pragma endregion
 
         #pragma region Enumeration methods
@@ -38,29 +110,13 @@ namespace klinker
             // Invalidate previous enumeration.
             FreeStrings();
 
-            // Device iterator
-            IDeckLinkIterator* iterator;
-            auto res = CoCreateInstance(
-                CLSID_CDeckLinkIterator, nullptr, CLSCTX_ALL,
-                IID_IDeckLinkIterator, reinterpret_cast<void**>(&iterator)
-            );
-
-            // If the driver is not found, return an empty list
-            // without emitting any error.
-            if (res != S_OK) return;
-
-            // Device name enumeration
-            IDeckLink* device;
-            while (iterator->Next(&device) == S_OK)
+            // If the driver is not found, the catalog is empty, so this
+            // returns an empty list without emitting any error.
+            DeviceCatalog::GetInstance().Access([&](const std::vector<DeviceInfo>& devices)
             {
-                BSTR name;
-                ShouldOK(device->GetDisplayName(&name));
-                names_.push_back(name);
-                device->Release();
-            }
-
-            // Cleaning up
-            iterator->Release();
+                for (const auto& info : devices)
+                    names_.push_back(SysAllocString(info.name));
+            });
         }
 
         void ScanOutputFormatNames(int deviceIndex)
@@ -68,58 +124,14 @@ namespace klinker
             // Invalidate previous enumeration.
             FreeStrings();
 
-            // Device iterator
-            IDeckLinkIterator* iterator;
-            auto res = CoCreateInstance(
-                CLSID_CDeckLinkIterator, nullptr, CLSCTX_ALL,
-                IID_IDeckLinkIterator, reinterpret_cast<void**>(&iterator)
-            );
-
-            // If the driver is not found, return an empty list
-            // without emitting any error.
-            if (res != S_OK) return;
-
-            // Iterate until reaching the specified index.
-            IDeckLink* device = nullptr;
-            for (auto i = 0; i <= deviceIndex; i++)
+            DeviceCatalog::GetInstance().Access([&](const std::vector<DeviceInfo>& devices)
             {
-                if (device !=  nullptr) device->Release();
-                if (iterator->Next(&device) != S_OK)
-                {
-                    // Wrong device index: Return an empty list.
-                    iterator->Release();
-                    return;
-                }
-            }
-
-            iterator->Release(); // The iterator is no longer needed.
-
-            // Output interface of the specified device
-            IDeckLinkOutput* output;
-            ShouldOK(device->QueryInterface(
-                IID_IDeckLinkOutput, reinterpret_cast<void**>(&output)
-            ));
-
-            device->Release(); // The device object is no longer needed.
-
-            // Display mode iterator
-            IDeckLinkDisplayModeIterator* dmIterator;
-            ShouldOK(output->GetDisplayModeIterator(&dmIterator));
+                // Wrong device index: Return an empty list.
+                if (deviceIndex < 0 || deviceIndex >= static_cast<int>(devices.size())) return;
 
-            output->Release(); // The output interface is no longer needed.
-
-            // Display mode name enumeration
-            IDeckLinkDisplayMode* mode;
-            while (dmIterator->Next(&mode) == S_OK)
-            {
-                BSTR name;
-                ShouldOK(mode->GetName(&name));
-                names_.push_back(name);
-                mode->Release();
-            }
-
-            // Cleaning up
-            dmIterator->Release();
+                for (const auto& mode : devices[deviceIndex].outputModes)
+                    names_.push_back(SysAllocString(mode.name));
+            });
         }
 
         #pragma endregion
@@ -136,6 +148,29 @@ namespace klinker
             names_.clear();
         }
 
+        static DisplayModeDescriptor ToDescriptor(const DisplayModeInfo& info)
+        {
+            DisplayModeDescriptor d = {};
+            d.mode = info.mode;
+            d.width = info.width;
+            d.height = info.height;
+            d.fieldDominance = info.fieldDominance;
+            d.frameDuration = info.frameDuration * flicksPerSecond / info.timeScale;
+            return d;
+        }
+
+        static const DisplayModeInfo* FindMode(const std::vector<DisplayModeInfo>& modes, BMDDisplayMode mode)
+        {
+            for (const auto& m : modes) if (m.mode == mode) return &m;
+            return nullptr;
+        }
+
+        static std::uint32_t FindInputFormats(const DeviceInfo& info, BMDDisplayMode mode)
+        {
+            auto m = FindMode(info.inputModes, mode);
+            return m != nullptr ? m->pixelFormats : 0;
+        }
+
         #pragma endregion
     };
 }
@@ -0,0 +1,244 @@
+#pragma once
+
+#include "Common.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace klinker
+{
+    //
+    // Allocator statistics
+    //
+    // Plain data structure passed to the managed side. The layout should be
+    // kept in sync with ReceiverPlugin.AllocatorStats.
+    //
+    struct AllocatorStats
+    {
+        std::int64_t allocationCount;   // Total number of AllocateBuffer calls
+        std::int64_t systemAllocations; // Allocations that hit the OS
+        std::int64_t activeBuffers;     // Buffers currently lent to the driver
+        std::int64_t peakActiveBuffers; // High-water mark of activeBuffers
+        std::int64_t reservedBytes;     // Memory owned by the pool
+        std::int64_t peakReservedBytes; // High-water mark of reservedBytes
+        std::int32_t largePages;        // Nonzero if backed by large pages
+    };
+
+    //
+    // Frame memory allocator class
+    //
+    // An IDeckLinkMemoryAllocator implementation that lets the driver DMA
+    // into page-aligned buffers owned by the plugin. Released buffers are
+    // kept in a free list and reused for the following frames, so the OS
+    // allocator is only hit while the pool is growing.
+    //
+    // Large pages are used when requested and available (it requires the
+    // SeLockMemoryPrivilege). It silently falls back to the regular pages
+    // when the allocation fails.
+    //
+    class FrameAllocator final : public IDeckLinkMemoryAllocator
+    {
+    public:
+
+        #pragma region Constructor/destructor
+
+        FrameAllocator(bool useLargePages)
+          : largePageSize_(useLargePages ? GetLargePageMinimum() : 0)
+        {
+        }
+
+        ~FrameAllocator()
+        {
+            // All the buffers should have been returned.
+            assert(stats_.activeBuffers == 0);
+            FreeAll();
+        }
+
+        #pragma endregion
+
+        #pragma region Accessor methods
+
+        AllocatorStats GetStats() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return stats_;
+        }
+
+        #pragma endregion
+
+        #pragma region IUnknown implementation
+
+        HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, LPVOID* ppv) override
+        {
+            if (iid == IID_IUnknown || iid == IID_IDeckLinkMemoryAllocator)
+            {
+                *ppv = static_cast<IDeckLinkMemoryAllocator*>(this);
+                AddRef();
+                return S_OK;
+            }
+
+            *ppv = nullptr;
+            return E_NOINTERFACE;
+        }
+
+        ULONG STDMETHODCALLTYPE AddRef() override
+        {
+            return refCount_.fetch_add(1);
+        }
+
+        ULONG STDMETHODCALLTYPE Release() override
+        {
+            auto val = refCount_.fetch_sub(1);
+            if (val == 1) delete this;
+            return val;
+        }
+
+        #pragma endregion
+
+        #pragma region IDeckLinkMemoryAllocator implementation
+
+        HRESULT STDMETHODCALLTYPE AllocateBuffer(
+            unsigned int bufferSize, void** allocatedBuffer
+        ) override
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            stats_.allocationCount++;
+
+            // Reuse a free buffer if there is a large enough one.
+            for (auto it = freeList_.begin(); it != freeList_.end(); ++it)
+            {
+                if (it->size < bufferSize) continue;
+                *allocatedBuffer = it->pointer;
+                usedList_.push_back(*it);
+                freeList_.erase(it);
+                CountActive(1);
+                return S_OK;
+            }
+
+            // Allocate a new buffer.
+            auto block = AllocateBlock(bufferSize);
+            if (block.pointer == nullptr)
+            {
+                *allocatedBuffer = nullptr;
+                return E_OUTOFMEMORY;
+            }
+
+            *allocatedBuffer = block.pointer;
+            usedList_.push_back(block);
+
+            stats_.systemAllocations++;
+            stats_.reservedBytes += block.size;
+            if (stats_.reservedBytes > stats_.peakReservedBytes)
+                stats_.peakReservedBytes = stats_.reservedBytes;
+
+            CountActive(1);
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE ReleaseBuffer(void* buffer) override
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            for (auto it = usedList_.begin(); it != usedList_.end(); ++it)
+            {
+                if (it->pointer != buffer) continue;
+                freeList_.push_back(*it);
+                usedList_.erase(it);
+                CountActive(-1);
+                return S_OK;
+            }
+
+            DebugLog("Unknown buffer was released to the frame allocator.");
+            return E_INVALIDARG;
+        }
+
+        HRESULT STDMETHODCALLTYPE Commit() override
+        {
+            return S_OK;
+        }
+
+        HRESULT STDMETHODCALLTYPE Decommit() override
+        {
+            // Give the free buffers back to the OS.
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto& block : freeList_) FreeBlock(block);
+            freeList_.clear();
+            return S_OK;
+        }
+
+        #pragma endregion
+
+    private:
+
+        #pragma region Private members
+
+        struct Block
+        {
+            void* pointer;
+            std::size_t size;
+        };
+
+        std::atomic<ULONG> refCount_ = 1;
+        mutable std::mutex mutex_;
+
+        std::vector<Block> freeList_;
+        std::vector<Block> usedList_;
+
+        std::size_t largePageSize_;
+        AllocatorStats stats_ = {};
+
+        void CountActive(int delta)
+        {
+            stats_.activeBuffers += delta;
+            if (stats_.activeBuffers > stats_.peakActiveBuffers)
+                stats_.peakActiveBuffers = stats_.activeBuffers;
+        }
+
+        Block AllocateBlock(std::size_t size)
+        {
+            // Large page allocation (the size should be rounded up)
+            if (largePageSize_ > 0)
+            {
+                auto rounded = (size + largePageSize_ - 1) / largePageSize_ * largePageSize_;
+                auto pointer = VirtualAlloc(
+                    nullptr, rounded,
+                    MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE
+                );
+
+                if (pointer != nullptr)
+                {
+                    stats_.largePages = 1;
+                    return { pointer, rounded };
+                }
+
+                // Large pages are unavailable: Don't try it again.
+                DebugLog("Large page allocation failed; Using regular pages.");
+                largePageSize_ = 0;
+            }
+
+            // Regular page allocation (always page aligned)
+            auto pointer = VirtualAlloc(
+                nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE
+            );
+
+            return { pointer, size };
+        }
+
+        void FreeBlock(const Block& block)
+        {
+            VirtualFree(block.pointer, 0, MEM_RELEASE);
+            stats_.reservedBytes -= block.size;
+        }
+
+        void FreeAll()
+        {
+            for (auto& block : freeList_) FreeBlock(block);
+            for (auto& block : usedList_) FreeBlock(block);
+            freeList_.clear();
+            usedList_.clear();
+        }
+
+        #pragma endregion
+    };
+}
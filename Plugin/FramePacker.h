@@ -0,0 +1,503 @@
+#pragma once
+
+#include "CpuFeatures.h"
+#include "V210Unpacker.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+#include <memory>
+#include <vector>
+
+namespace klinker
+{
+    //
+    // Frame packer class
+    //
+    // Packs RGBA frames (8-bit or half-precision) into the output pixel
+    // formats on the CPU: 8-bit UYVY, 10-bit v210 and 8-bit BGRA. It's an
+    // alternative to the subsampler shader, and the YUV conversion is the
+    // same as RGB2YUV in Subsampler.cginc (Rec.709 limited range; the chroma
+    // is the average of each horizontal pixel pair).
+    //
+    // Input values are converted into gamma-space floats with lookup tables,
+    // which also take care of the linear-to-gamma conversion of linear
+    // half-precision input. The YUV kernels are AVX2/SSE4.1 with a scalar
+    // fallback (bit-identical), selected at run time.
+    //
+    // v210 rows are converted into a 10-bit UYVY scratch row, then packed
+    // into 32-bit words. The row padding is filled with black.
+    //
+    class FramePacker final
+    {
+    public:
+
+        #pragma region Setup methods
+
+        // Not thread safe
+        void Reset(int width, bool halfInput, bool linearInput)
+        {
+            width_ = width;
+            halfInput_ = halfInput;
+
+            if (!halfInput)
+                table_ = GetUNorm8Table();
+            else if (linearInput)
+                table_ = GetHalfLinearTable();
+            else
+                table_ = GetHalfTable();
+
+            // 10-bit scratch row padded to the v210 block size
+            // (initialized with black: Y = 64, C = 512)
+            auto padded = (width + 47) / 48 * 48;
+            scratch_.resize((std::size_t)padded * 2);
+            for (std::size_t i = 0; i < scratch_.size(); i++)
+                scratch_[i] = (i & 1) ? 64 : 512;
+        }
+
+        std::size_t GetInputRowBytes() const
+        {
+            return (std::size_t)width_ * (halfInput_ ? 8 : 4);
+        }
+
+        static std::size_t GetUYVYRowBytes(int width)
+        {
+            return (std::size_t)width * 2;
+        }
+
+        static std::size_t GetV210RowBytes(int width)
+        {
+            return V210Unpacker::GetRowBytes(width);
+        }
+
+        static std::size_t GetBGRARowBytes(int width)
+        {
+            return (std::size_t)width * 4;
+        }
+
+        #pragma endregion
+
+        #pragma region Packing methods
+
+        void PackUYVY(
+            const void* source, std::size_t sourceRowBytes,
+            void* dest, std::size_t destRowBytes, int height
+        ) const
+        {
+            auto kernel = SelectKernel();
+            auto src = static_cast<const std::uint8_t*>(source);
+            auto dst = static_cast<std::uint8_t*>(dest);
+
+            for (auto y = 0; y < height; y++)
+                (this->*kernel)(src + sourceRowBytes * y, dst + destRowBytes * y, false);
+        }
+
+        void PackV210(
+            const void* source, std::size_t sourceRowBytes,
+            void* dest, std::size_t destRowBytes, int height
+        )
+        {
+            auto kernel = SelectKernel();
+            auto pack = CpuFeatures::HasSSE41() ? PackWordsSSE41 : PackWordsScalar;
+            auto src = static_cast<const std::uint8_t*>(source);
+            auto dst = static_cast<std::uint8_t*>(dest);
+            auto groups = static_cast<int>(scratch_.size() / 12);
+
+            for (auto y = 0; y < height; y++)
+            {
+                (this->*kernel)(src + sourceRowBytes * y, scratch_.data(), true);
+                pack(scratch_.data(), reinterpret_cast<std::uint32_t*>(dst + destRowBytes * y), groups);
+            }
+        }
+
+        void PackBGRA(
+            const void* source, std::size_t sourceRowBytes,
+            void* dest, std::size_t destRowBytes, int height
+        ) const
+        {
+            auto src = static_cast<const std::uint8_t*>(source);
+            auto dst = static_cast<std::uint8_t*>(dest);
+
+            for (auto y = 0; y < height; y++)
+            {
+                auto s = src + sourceRowBytes * y;
+                auto d = dst + destRowBytes * y;
+
+                if (!halfInput_ && CpuFeatures::HasSSE41())
+                {
+                    // 8-bit input: R/B swizzling
+                    const auto mask = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+                    auto x = 0;
+                    for (; x + 4 <= width_; x += 4)
+                    {
+                        auto p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + x * 4));
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + x * 4), _mm_shuffle_epi8(p, mask));
+                    }
+                    for (; x < width_; x++) StoreBGRA(s, d, x);
+                }
+                else
+                {
+                    for (auto x = 0; x < width_; x++) StoreBGRA(s, d, x);
+                }
+            }
+        }
+
+        #pragma endregion
+
+    private:
+
+        #pragma region Private members
+
+        int width_ = 0;
+        bool halfInput_ = false;
+        const float* table_ = nullptr;
+        std::vector<std::uint16_t> scratch_;
+
+        #pragma endregion
+
+        #pragma region Lookup tables
+
+        template <typename F>
+        static std::unique_ptr<float[]> BuildTable(int size, F function)
+        {
+            std::unique_ptr<float[]> table(new float[size]);
+            for (auto i = 0; i < size; i++) table[i] = function(i);
+            return table;
+        }
+
+        // Half -> float (negative values and NaNs -> 0, infinity -> max)
+        static float HalfToFloat(int h)
+        {
+            auto exp = (h >> 10) & 0x1f;
+            auto man = h & 0x3ff;
+            if (h & 0x8000) return 0;
+            if (exp == 0x1f) return man ? 0 : 65504.0f;
+            if (exp == 0) return std::ldexp(static_cast<float>(man), -24);
+            return std::ldexp(static_cast<float>(man | 0x400), exp - 25);
+        }
+
+        // Same as LinearToGammaSpace in UnityCG.cginc
+        static float LinearToGamma(float c)
+        {
+            auto g = 1.055 * std::pow(static_cast<double>(c), 0.416666667) - 0.055;
+            return static_cast<float>(std::max(g, 0.0));
+        }
+
+        static const float* GetUNorm8Table()
+        {
+            static const auto table = BuildTable(256, [](int i) { return i / 255.0f; });
+            return table.get();
+        }
+
+        static const float* GetHalfTable()
+        {
+            static const auto table = BuildTable(0x10000, HalfToFloat);
+            return table.get();
+        }
+
+        static const float* GetHalfLinearTable()
+        {
+            static const auto table = BuildTable(0x10000, [](int i) {
+                return LinearToGamma(HalfToFloat(i));
+            });
+            return table.get();
+        }
+
+        #pragma endregion
+
+        #pragma region Kernel selector
+
+        using RowKernel = void (FramePacker::*)(const std::uint8_t*, void*, bool) const;
+
+        static RowKernel SelectKernel()
+        {
+            if (CpuFeatures::HasAVX2()) return &FramePacker::PackRowAVX2;
+            if (CpuFeatures::HasSSE41()) return &FramePacker::PackRowSSE41;
+            return &FramePacker::PackRowScalar;
+        }
+
+        #pragma endregion
+
+        #pragma region Scalar implementation
+
+        // Rec.709 coefficients (same as Subsampler.cginc)
+        static float K_R() { return 0.2126f; }
+        static float K_B() { return 0.0722f; }
+        static float K_G() { return 1 - K_B() - K_R(); }
+
+        // Quantization levels (8-bit or 10-bit code values)
+        struct Levels
+        {
+            float yScale, yOffset, uScale, vScale, cOffset, lo, hi;
+        };
+
+        static Levels GetLevels(bool tenBit)
+        {
+            if (tenBit)
+                return { 876, 64, 448 / (1 - K_B()), 448 / (1 - K_R()), 512, 4, 1019 };
+            else
+                return { 219, 16, 112 / (1 - K_B()), 112 / (1 - K_R()), 128, 0, 255 };
+        }
+
+        void Fetch(const std::uint8_t* src, int x, float& r, float& g, float& b) const
+        {
+            if (halfInput_)
+            {
+                auto p = reinterpret_cast<const std::uint16_t*>(src) + x * 4;
+                r = table_[p[0]]; g = table_[p[1]]; b = table_[p[2]];
+            }
+            else
+            {
+                auto p = src + x * 4;
+                r = table_[p[0]]; g = table_[p[1]]; b = table_[p[2]];
+            }
+        }
+
+        static int Quantize(float x, const Levels& lv)
+        {
+            return static_cast<int>(std::min(std::max(x, lv.lo), lv.hi) + 0.5f);
+        }
+
+        template <typename T>
+        void PackRowPairs(const std::uint8_t* src, T* dst, int x0, const Levels& lv) const
+        {
+            for (auto x = x0; x < width_; x += 2)
+            {
+                float r0, g0, b0, r1, g1, b1;
+                Fetch(src, x, r0, g0, b0);
+                Fetch(src, x + 1, r1, g1, b1);
+
+                auto y0 = (K_R() * r0 + K_G() * g0) + K_B() * b0;
+                auto y1 = (K_R() * r1 + K_G() * g1) + K_B() * b1;
+
+                auto u0 = (b0 - y0) * lv.uScale + lv.cOffset;
+                auto u1 = (b1 - y1) * lv.uScale + lv.cOffset;
+                auto v0 = (r0 - y0) * lv.vScale + lv.cOffset;
+                auto v1 = (r1 - y1) * lv.vScale + lv.cOffset;
+
+                auto d = dst + x * 2;
+                d[0] = static_cast<T>(Quantize((u0 + u1) * 0.5f, lv));
+                d[1] = static_cast<T>(Quantize(y0 * lv.yScale + lv.yOffset, lv));
+                d[2] = static_cast<T>(Quantize((v0 + v1) * 0.5f, lv));
+                d[3] = static_cast<T>(Quantize(y1 * lv.yScale + lv.yOffset, lv));
+            }
+        }
+
+        // Convert pixels from x0 to the end of the row.
+        void PackRowTail(const std::uint8_t* src, void* dst, bool tenBit, int x0) const
+        {
+            auto lv = GetLevels(tenBit);
+            if (tenBit)
+                PackRowPairs(src, static_cast<std::uint16_t*>(dst), x0, lv);
+            else
+                PackRowPairs(src, static_cast<std::uint8_t*>(dst), x0, lv);
+        }
+
+        void PackRowScalar(const std::uint8_t* src, void* dst, bool tenBit) const
+        {
+            PackRowTail(src, dst, tenBit, 0);
+        }
+
+        void StoreBGRA(const std::uint8_t* src, std::uint8_t* dst, int x) const
+        {
+            float r, g, b;
+            Fetch(src, x, r, g, b);
+            auto d = dst + x * 4;
+            d[0] = static_cast<std::uint8_t>(std::min(std::max(b, 0.0f), 1.0f) * 255 + 0.5f);
+            d[1] = static_cast<std::uint8_t>(std::min(std::max(g, 0.0f), 1.0f) * 255 + 0.5f);
+            d[2] = static_cast<std::uint8_t>(std::min(std::max(r, 0.0f), 1.0f) * 255 + 0.5f);
+            d[3] = 0xff;
+        }
+
+        // 10-bit UYVY samples -> v210 words (12 samples per group)
+        static void PackWordsScalar(const std::uint16_t* src, std::uint32_t* dst, int groups)
+        {
+            for (auto i = 0; i < groups * 4; i++, src += 3)
+                dst[i] = src[0] | (src[1] << 10) | (static_cast<std::uint32_t>(src[2]) << 20);
+        }
+
+        #pragma endregion
+
+        #pragma region SSE4.1 implementation
+
+        // Word order in a packed lane: (Y0 Y1 Y2 Y3 U0 U1 V0 V1) -> UYVY
+        #define KLINKER_UYVY_REORDER 8,9, 0,1, 12,13, 2,3, 10,11, 4,5, 14,15, 6,7
+
+        // Convert four pixels and pack them into 16-bit UYVY samples.
+        static __m128i PackPixels(__m128 r, __m128 g, __m128 b, const Levels& lv)
+        {
+            auto y = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(K_R()), r), _mm_mul_ps(_mm_set1_ps(K_G()), g)),
+                _mm_mul_ps(_mm_set1_ps(K_B()), b)
+            );
+
+            auto u = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(b, y), _mm_set1_ps(lv.uScale)), _mm_set1_ps(lv.cOffset));
+            auto v = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(r, y), _mm_set1_ps(lv.vScale)), _mm_set1_ps(lv.cOffset));
+
+            // Luma and averaged chroma (U0 U1 V0 V1)
+            auto yc = _mm_add_ps(_mm_mul_ps(y, _mm_set1_ps(lv.yScale)), _mm_set1_ps(lv.yOffset));
+            auto cc = _mm_mul_ps(_mm_hadd_ps(u, v), _mm_set1_ps(0.5f));
+
+            auto packed = _mm_packus_epi32(Quantize(yc, lv), Quantize(cc, lv));
+            return _mm_shuffle_epi8(packed, _mm_setr_epi8(KLINKER_UYVY_REORDER));
+        }
+
+        static __m128i Quantize(__m128 x, const Levels& lv)
+        {
+            x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(lv.lo)), _mm_set1_ps(lv.hi));
+            return _mm_cvttps_epi32(_mm_add_ps(x, _mm_set1_ps(0.5f)));
+        }
+
+        void PackRowSSE41(const std::uint8_t* src, void* dst, bool tenBit) const
+        {
+            auto lv = GetLevels(tenBit);
+            auto count = width_ / 4;
+
+            for (auto i = 0; i < count; i++)
+            {
+                // Table lookups (no gather instruction in SSE)
+                alignas(16) float r[4], g[4], b[4];
+                for (auto j = 0; j < 4; j++) Fetch(src, i * 4 + j, r[j], g[j], b[j]);
+
+                auto w = PackPixels(_mm_load_ps(r), _mm_load_ps(g), _mm_load_ps(b), lv);
+
+                if (tenBit)
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(static_cast<std::uint16_t*>(dst) + i * 8), w);
+                else
+                    _mm_storel_epi64(reinterpret_cast<__m128i*>(static_cast<std::uint8_t*>(dst) + i * 8), _mm_packus_epi16(w, w));
+            }
+
+            // Remaining pixels
+            PackRowTail(src, dst, tenBit, count * 4);
+        }
+
+        // 10-bit UYVY samples -> v210 words
+        static void PackWordsSSE41(const std::uint16_t* src, std::uint32_t* dst, int groups)
+        {
+            const auto a0 = _mm_setr_epi8(0, 1, -1, -1, 6, 7, -1, -1, 12, 13, -1, -1, -1, -1, -1, -1);
+            const auto a1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 3, -1, -1);
+            const auto b0 = _mm_setr_epi8(2, 3, -1, -1, 8, 9, -1, -1, 14, 15, -1, -1, -1, -1, -1, -1);
+            const auto b1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 4, 5, -1, -1);
+            const auto c0 = _mm_setr_epi8(4, 5, -1, -1, 10, 11, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+            const auto c1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, 0, 1, -1, -1, 6, 7, -1, -1);
+
+            for (auto i = 0; i < groups; i++, src += 12, dst += 4)
+            {
+                auto s0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+                auto s1 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + 8));
+
+                auto a = _mm_or_si128(_mm_shuffle_epi8(s0, a0), _mm_shuffle_epi8(s1, a1));
+                auto b = _mm_or_si128(_mm_shuffle_epi8(s0, b0), _mm_shuffle_epi8(s1, b1));
+                auto c = _mm_or_si128(_mm_shuffle_epi8(s0, c0), _mm_shuffle_epi8(s1, c1));
+
+                auto w = _mm_or_si128(a, _mm_or_si128(_mm_slli_epi32(b, 10), _mm_slli_epi32(c, 20)));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), w);
+            }
+        }
+
+        #pragma endregion
+
+        #pragma region AVX2 implementation
+
+        // Convert eight pixels (four per lane) into 16-bit UYVY samples.
+        static __m256i PackPixels(__m256 r, __m256 g, __m256 b, const Levels& lv)
+        {
+            auto y = _mm256_add_ps(
+                _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(K_R()), r), _mm256_mul_ps(_mm256_set1_ps(K_G()), g)),
+                _mm256_mul_ps(_mm256_set1_ps(K_B()), b)
+            );
+
+            auto u = _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(b, y), _mm256_set1_ps(lv.uScale)), _mm256_set1_ps(lv.cOffset));
+            auto v = _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(r, y), _mm256_set1_ps(lv.vScale)), _mm256_set1_ps(lv.cOffset));
+
+            auto yc = _mm256_add_ps(_mm256_mul_ps(y, _mm256_set1_ps(lv.yScale)), _mm256_set1_ps(lv.yOffset));
+            auto cc = _mm256_mul_ps(_mm256_hadd_ps(u, v), _mm256_set1_ps(0.5f));
+
+            auto packed = _mm256_packus_epi32(Quantize(yc, lv), Quantize(cc, lv));
+            return _mm256_shuffle_epi8(packed, _mm256_setr_epi8(KLINKER_UYVY_REORDER, KLINKER_UYVY_REORDER));
+        }
+
+        static __m256i Quantize(__m256 x, const Levels& lv)
+        {
+            x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(lv.lo)), _mm256_set1_ps(lv.hi));
+            return _mm256_cvttps_epi32(_mm256_add_ps(x, _mm256_set1_ps(0.5f)));
+        }
+
+        // Load eight pixels and look up the tables.
+        void FetchAVX2(const std::uint8_t* src, __m256& r, __m256& g, __m256& b) const
+        {
+            __m256i ri, gi, bi;
+
+            if (halfInput_)
+            {
+                // Two pixels per lane: Gather the components into 32-bit
+                // lanes, then fix the order with a qword permutation.
+                const auto mrg = _mm256_setr_epi8(
+                    0, 1, -1, -1, 8, 9, -1, -1, 2, 3, -1, -1, 10, 11, -1, -1,
+                    0, 1, -1, -1, 8, 9, -1, -1, 2, 3, -1, -1, 10, 11, -1, -1
+                );
+                const auto mb = _mm256_setr_epi8(
+                    4, 5, -1, -1, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                    4, 5, -1, -1, 12, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+                );
+
+                auto lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+                auto hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 32));
+
+                auto lorg = _mm256_shuffle_epi8(lo, mrg);
+                auto hirg = _mm256_shuffle_epi8(hi, mrg);
+
+                const int order = _MM_SHUFFLE(3, 1, 2, 0);
+                ri = _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(lorg, hirg), order);
+                gi = _mm256_permute4x64_epi64(_mm256_unpackhi_epi64(lorg, hirg), order);
+                bi = _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(
+                    _mm256_shuffle_epi8(lo, mb), _mm256_shuffle_epi8(hi, mb)), order);
+            }
+            else
+            {
+                const auto mask = _mm256_set1_epi32(0xff);
+                auto p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+                ri = _mm256_and_si256(p, mask);
+                gi = _mm256_and_si256(_mm256_srli_epi32(p, 8), mask);
+                bi = _mm256_and_si256(_mm256_srli_epi32(p, 16), mask);
+            }
+
+            r = _mm256_i32gather_ps(table_, ri, 4);
+            g = _mm256_i32gather_ps(table_, gi, 4);
+            b = _mm256_i32gather_ps(table_, bi, 4);
+        }
+
+        void PackRowAVX2(const std::uint8_t* src, void* dst, bool tenBit) const
+        {
+            auto lv = GetLevels(tenBit);
+            auto bpp = halfInput_ ? 8 : 4;
+            auto count = width_ / 8;
+
+            for (auto i = 0; i < count; i++)
+            {
+                __m256 r, g, b;
+                FetchAVX2(src + i * 8 * bpp, r, g, b);
+
+                auto w = PackPixels(r, g, b, lv);
+
+                if (tenBit)
+                {
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(static_cast<std::uint16_t*>(dst) + i * 16), w);
+                }
+                else
+                {
+                    // Lower qwords of the two lanes
+                    auto b8 = _mm256_permute4x64_epi64(_mm256_packus_epi16(w, w), 0x08);
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(static_cast<std::uint8_t*>(dst) + i * 16), _mm256_castsi256_si128(b8));
+                }
+            }
+
+            // Remaining pixels
+            PackRowTail(src, dst, tenBit, count * 8);
+        }
+
+        #undef KLINKER_UYVY_REORDER
+
+        #pragma endregion
+    };
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Common.h"
+#include <memory>
+#include <vector>
+
+namespace klinker
+{
+    //
+    // Frame buffer pool class
+    //
+    // Holds a fixed number of preallocated frame buffers that are recycled
+    // through the frame queue (one buffer per queue slot). Reallocation only
+    // happens when the requested buffer size or count is changed, so there
+    // is no allocator traffic in steady state.
+    //
+    // This class is not thread safe. The owner is responsible for
+    // synchronization.
+    //
+    class FramePool final
+    {
+    public:
+
+        #pragma region Accessor methods
+
+        std::size_t GetBufferSize() const
+        {
+            return bufferSize_;
+        }
+
+        std::size_t CountBuffers() const
+        {
+            return buffers_.size();
+        }
+
+        std::uint8_t* GetBuffer(std::size_t index) const
+        {
+            return buffers_[index].get();
+        }
+
+        #pragma endregion
+
+        #pragma region Public methods
+
+        // Reallocate the buffers if the size or the count was changed.
+        // Returns true if reallocation happened. All the buffers previously
+        // retrieved become invalid in that case.
+        bool Resize(std::size_t count, std::size_t size)
+        {
+            if (count == buffers_.size() && size == bufferSize_) return false;
+
+            DebugLog("Frame pool reallocation.");
+
+            buffers_.clear();
+
+            for (std::size_t i = 0; i < count; i++)
+                buffers_.emplace_back(new std::uint8_t[size]);
+
+            bufferSize_ = size;
+            return true;
+        }
+
+        #pragma endregion
+
+    private:
+
+        #pragma region Private members
+
+        std::vector<std::unique_ptr<std::uint8_t[]>> buffers_;
+        std::size_t bufferSize_ = 0;
+
+        #pragma endregion
+    };
+}
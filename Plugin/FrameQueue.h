@@ -0,0 +1,212 @@
+#pragma once
+
+#include "Common.h"
+#include <atomic>
+#include <vector>
+
+namespace klinker
+{
+    //
+    // Lock-free frame queue class
+    //
+    // A single-producer/single-consumer ring buffer. Pushing is wait-free
+    // on the producer side (the capture callback thread), and popping is
+    // done on the consumer side (the main thread).
+    //
+    // There are other readers on the consumer side: The render thread reads
+    // the oldest slot while uploading it to a texture, the CPU color
+    // converter reads it while converting, and the main thread reads its
+    // metadata on dequeuing and querying. A reader "pins" the slot during the access so
+    // that the producer doesn't overwrite it even if it's popped in the
+    // meantime. Each reader has its own pin (see maxReaders).
+    //
+    // The producer is also allowed to discard queued slots (flushing), so
+    // the head index is advanced with CAS operations.
+    //
+    // Slots are never destructed or cleared on popping. The popping side
+    // can take over the content of the slot (see PopPinned); The producer
+    // recycles the rest of it on reuse.
+    //
+    template <typename T> class FrameQueue final
+    {
+    public:
+
+        // Number of the reader pins
+        static const int maxReaders = 3;
+
+        #pragma region Constructor
+
+        FrameQueue()
+        {
+            for (auto& pin : pinned_) pin = noPin_;
+        }
+
+        #pragma endregion
+
+        #pragma region Accessor methods
+
+        // Not thread safe: Should be called only while stopped.
+        void Reset(std::size_t capacity)
+        {
+            slots_.clear();
+            slots_.resize(capacity);
+            head_ = tail_ = 0;
+            for (auto& pin : pinned_) pin = noPin_;
+        }
+
+        std::size_t GetCapacity() const
+        {
+            return slots_.size();
+        }
+
+        std::size_t CountQueued() const
+        {
+            // Load the head first; the tail can only move forward.
+            auto head = head_.load();
+            return static_cast<std::size_t>(tail_.load() - head);
+        }
+
+        // Direct slot access for initialization and cleanup
+        // Not thread safe: Should be called only while stopped, or on a
+        // slot that the caller has just popped (on the producer side, or
+        // under a pin on the reader side).
+        T& GetSlot(std::size_t index)
+        {
+            return slots_[index];
+        }
+
+        #pragma endregion
+
+        #pragma region Producer side methods
+
+        // Get a writable slot at the tail. Returns nullptr when the queue
+        // is full or the slot is pinned by a reader.
+        T* BeginPush()
+        {
+            auto tail = tail_.load(std::memory_order_relaxed);
+            if (tail - head_.load() >= slots_.size()) return nullptr;
+            for (auto& pin : pinned_)
+                if (pin.load() == tail % slots_.size()) return nullptr;
+            return &slots_[tail % slots_.size()];
+        }
+
+        // Publish the slot taken with BeginPush.
+        void EndPush()
+        {
+            tail_.fetch_add(1);
+        }
+
+        #pragma endregion
+
+        #pragma region Consumer side methods
+
+        // Discard the oldest slot. Returns false when the queue is empty.
+        // This can be called from both sides. The index of the discarded
+        // slot is stored in "index" if given.
+        bool Pop(std::size_t* index = nullptr)
+        {
+            auto head = head_.load();
+            do
+            {
+                if (head == tail_.load()) return false;
+            }
+            while (!head_.compare_exchange_weak(head, head + 1));
+            if (index != nullptr) *index = head % slots_.size();
+            return true;
+        }
+
+        // Discard all the queued slots. This can be called from both sides.
+        // Returns the number of the discarded slots.
+        std::size_t Flush()
+        {
+            auto head = head_.load();
+            auto tail = tail_.load();
+            while (!head_.compare_exchange_weak(head, tail)) tail = tail_.load();
+            return static_cast<std::size_t>(tail - head);
+        }
+
+        #pragma endregion
+
+        #pragma region Reader side methods
+
+        // Pin the oldest slot to protect it from being overwritten. Returns
+        // nullptr when the queue is empty. A reader can hold only one pin.
+        const T* Pin(int reader = 0)
+        {
+            auto& pin = pinned_[reader];
+            assert(pin.load() == noPin_);
+
+            for (;;)
+            {
+                auto head = head_.load();
+                if (head == tail_.load()) return nullptr;
+
+                // Publish the pin, then check if the slot is still alive.
+                pin.store(head % slots_.size());
+                if (head_.load() == head) return &slots_[head % slots_.size()];
+
+                // The slot was popped in the meantime: Retry.
+                pin.store(noPin_);
+            }
+        }
+
+        void Unpin(int reader = 0)
+        {
+            pinned_[reader].store(noPin_);
+        }
+
+        // Discard the oldest slot only if it's the one pinned by a reader.
+        // Returns false when it has been already discarded by the other
+        // side. The producer can't reuse the slot until it's unpinned, so
+        // the reader can safely take over its content in the meantime.
+        bool PopPinned(int reader, std::size_t* index = nullptr)
+        {
+            auto pin = pinned_[reader].load();
+            if (pin == noPin_) return false;
+
+            auto head = head_.load();
+            do
+            {
+                if (head == tail_.load() || head % slots_.size() != pin) return false;
+            }
+            while (!head_.compare_exchange_weak(head, head + 1));
+            if (index != nullptr) *index = pin;
+            return true;
+        }
+
+        // Returns true if any reader holds a pin.
+        bool IsPinned() const
+        {
+            for (auto& pin : pinned_)
+                if (pin.load() != noPin_) return true;
+            return false;
+        }
+
+        // Returns true if any reader holds a pin on a given slot.
+        bool IsPinned(std::size_t index) const
+        {
+            for (auto& pin : pinned_)
+                if (pin.load() == index) return true;
+            return false;
+        }
+
+        #pragma endregion
+
+    private:
+
+        #pragma region Private members
+
+        static const std::size_t noPin_ = ~static_cast<std::size_t>(0);
+
+        std::vector<T> slots_;
+
+        // Monotonic counters (slot index = counter % capacity)
+        std::atomic<std::uint64_t> head_ = 0;
+        std::atomic<std::uint64_t> tail_ = 0;
+
+        // Slot indices pinned by the readers
+        std::atomic<std::size_t> pinned_[maxReaders];
+
+        #pragma endregion
+    };
+}
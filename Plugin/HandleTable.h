@@ -0,0 +1,130 @@
+#pragma once
+
+#include "Common.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+namespace klinker
+{
+    //
+    // Handle table class
+    //
+    // A fixed-capacity slot table that binds object pointers to 32-bit
+    // handles. A handle consists of a slot index (lower bits) and the
+    // generation of the slot (upper bits), so a stale handle never resolves
+    // to an object that reuses the slot. Zero is never used as a handle.
+    //
+    // Lookup is lock-free and can be done on any thread (e.g. the render
+    // thread). A lookup pins the slot while the object is accessed, and
+    // Remove waits for the pins to be released, so the object can be safely
+    // destroyed after Remove. Add/Remove are serialized with a mutex.
+    //
+    // Pins are counted in two phases: Remove flips the phase of the slot and
+    // waits only for the pins of the previous phase, so it can't be starved
+    // by continuous lookups.
+    //
+    template <typename T, int IndexBits = 6>
+    class HandleTable final
+    {
+    public:
+
+        static const int capacity = 1 << IndexBits;
+
+        #pragma region Modifier methods
+
+        // Returns zero when the table is full.
+        std::uint32_t Add(T* instance)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            for (auto i = 0; i < capacity; i++)
+            {
+                auto& slot = slots_[i];
+                if (slot.object.load() != nullptr) continue;
+
+                // Generation (wrapping around the upper bits, non-zero)
+                if (++slot.generation >= (1U << (32 - IndexBits))) slot.generation = 1;
+
+                auto handle = (slot.generation << IndexBits) | static_cast<std::uint32_t>(i);
+                slot.object.store(instance);
+                slot.handle.store(handle);
+                return handle;
+            }
+
+            return 0;
+        }
+
+        // Unbind a handle. Waits until no one accesses the object.
+        void Remove(std::uint32_t handle)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            auto& slot = GetSlot(handle);
+            if (handle == 0 || slot.handle.load() != handle) return;
+
+            // Invalidate the handle, flip the phase, then wait for the pins
+            // of the previous phase.
+            slot.handle.store(0);
+            auto phase = slot.phase.fetch_xor(1);
+            while (slot.pins[phase].load() != 0) std::this_thread::yield();
+
+            slot.object.store(nullptr);
+        }
+
+        #pragma endregion
+
+        #pragma region Lookup methods
+
+        // Call a function with the object bound to a handle. Returns false
+        // (without calling it) when the handle is stale or invalid. The
+        // object is guaranteed to be alive during the call.
+        template <typename F>
+        bool Access(std::uint32_t handle, F function) const
+        {
+            if (handle == 0) return false;
+
+            auto& slot = GetSlot(handle);
+
+            auto phase = slot.phase.load();
+            slot.pins[phase]++;
+
+            auto valid = slot.handle.load() == handle;
+            if (valid) function(slot.object.load());
+
+            slot.pins[phase]--;
+
+            return valid;
+        }
+
+        #pragma endregion
+
+    private:
+
+        #pragma region Private members
+
+        struct Slot
+        {
+            std::atomic<std::uint32_t> handle = 0; // Zero: unbound
+            std::atomic<T*> object = nullptr;
+            mutable std::atomic<int> pins[2] = {};
+            std::atomic<int> phase = 0;
+            std::uint32_t generation = 0;          // Guarded by mutex_
+        };
+
+        Slot slots_[capacity];
+        std::mutex mutex_;
+
+        Slot& GetSlot(std::uint32_t handle)
+        {
+            return slots_[handle & (capacity - 1)];
+        }
+
+        const Slot& GetSlot(std::uint32_t handle) const
+        {
+            return slots_[handle & (capacity - 1)];
+        }
+
+        #pragma endregion
+    };
+}
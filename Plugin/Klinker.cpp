@@ -1,15 +1,32 @@
 #include "Enumerator.h"
-#include "ObjectIDMap.h"
+#include "HandleTable.h"
 #include "Receiver.h"
 #include "Sender.h"
+#include "SenderGroup.h"
 #include "Unity/IUnityRenderingExtensions.h"
 
 #pragma region Local functions
 
 namespace
 {
-    // ID-receiver map
-    klinker::ObjectIDMap<klinker::Receiver> receiverMap_;
+    // Receiver handle table (IDs used on the render thread)
+    klinker::HandleTable<klinker::Receiver> receiverTable_;
+
+    // Receivers being uploaded (render thread only, indexed by the slot of
+    // the handle). An upload holds a reference to the receiver and its pin
+    // until the end event, even if the receiver is destroyed in between.
+    struct TextureUpload
+    {
+        std::uint32_t handle;
+        klinker::Receiver* receiver;
+    };
+
+    TextureUpload uploads_[klinker::HandleTable<klinker::Receiver>::capacity];
+
+    TextureUpload& GetUpload(std::uint32_t handle)
+    {
+        return uploads_[handle & (klinker::HandleTable<klinker::Receiver>::capacity - 1)];
+    }
 
     // Callback for texture update events
     void TextureUpdateCallback(int eventID, void* data)
@@ -19,25 +36,33 @@ namespace
         {
             // UpdateTextureBegin
             auto params = reinterpret_cast<UnityRenderingExtTextureUpdateParamsV2*>(data);
-            auto receiver = receiverMap_[params->userData];
-            if (receiver == nullptr) return;
-
-            // Check if the size of the data matches.
-            auto dataSize = params->width * params->height * params->bpp;
-            if (receiver->CalculateFrameDataSize() != dataSize) return;
-
-            // Lock the frame data for the update.
-            params->texData = const_cast<uint8_t*>(receiver->LockOldestFrameData());
+            receiverTable_.Access(params->userData, [=](klinker::Receiver* receiver)
+            {
+                // Check if the size of the data matches.
+                auto dataSize = params->width * params->height * params->bpp;
+                if (receiver->CalculateFrameDataSize() != dataSize) return;
+
+                // Lock the frame data for the update.
+                params->texData = const_cast<uint8_t*>(receiver->LockOldestFrameData());
+                if (params->texData == nullptr) return;
+
+                // Keep the receiver alive until the end event.
+                receiver->AddRef();
+                GetUpload(params->userData) = { params->userData, receiver };
+            });
         }
         else if (event == kUnityRenderingExtEventUpdateTextureEndV2)
         {
             // UpdateTextureEnd
+            // This doesn't look up the handle table, as the handle may have
+            // been removed after the begin event.
             auto params = reinterpret_cast<UnityRenderingExtTextureUpdateParamsV2*>(data);
-            auto receiver = receiverMap_[params->userData];
-            if (receiver == nullptr) return;
+            auto& upload = GetUpload(params->userData);
+            if (upload.receiver == nullptr || upload.handle != params->userData) return;
 
-            // Unlock the frame data if it seems to be locked.
-            if (params->texData != nullptr) receiver->UnlockOldestFrameData();
+            upload.receiver->UnlockOldestFrameData();
+            upload.receiver->Release();
+            upload = {};
         }
     }
 }
@@ -69,6 +94,18 @@ extern "C" int UNITY_INTERFACE_EXPORT RetrieveOutputFormatNames(int deviceIndex,
     return enumerator_.CopyStringPointers(names, maxCount);
 }
 
+extern "C" int UNITY_INTERFACE_EXPORT RetrieveDeviceIDs(klinker::DeviceIDs ids[], int maxCount)
+{
+    if (ids == nullptr) return 0;
+    return klinker::Enumerator::CopyDeviceIDs(ids, maxCount);
+}
+
+extern "C" int UNITY_INTERFACE_EXPORT RetrieveDisplayModes(int deviceIndex, klinker::DisplayModeDescriptor modes[], int maxCount)
+{
+    if (modes == nullptr) return 0;
+    return klinker::Enumerator::CopyDisplayModes(deviceIndex, modes, maxCount);
+}
+
 #pragma endregion
 
 #pragma region Receiver plugin functions
@@ -76,16 +113,40 @@ extern "C" int UNITY_INTERFACE_EXPORT RetrieveOutputFormatNames(int deviceIndex,
 extern "C" void UNITY_INTERFACE_EXPORT * CreateReceiver(int device, int format)
 {
     auto instance = new klinker::Receiver();
-    receiverMap_.Add(instance);
+    instance->SetHandle(receiverTable_.Add(instance));
     instance->Start(device, format);
     return instance;
 }
 
+extern "C" void UNITY_INTERFACE_EXPORT * CreateReceiverWithSettings(int device, int format, const klinker::ReceiverSettings* settings)
+{
+    auto instance = new klinker::Receiver(settings != nullptr ? *settings : klinker::ReceiverSettings());
+    instance->SetHandle(receiverTable_.Add(instance));
+    instance->Start(device, format);
+    return instance;
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT * CreateReceiverByID(std::int64_t deviceID, std::uint32_t mode)
+{
+    auto instance = new klinker::Receiver();
+    instance->SetHandle(receiverTable_.Add(instance));
+    instance->Start(klinker::DeviceCatalog::GetInstance().SelectByID(deviceID, mode));
+    return instance;
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT * CreateReceiverByIDWithSettings(std::int64_t deviceID, std::uint32_t mode, const klinker::ReceiverSettings* settings)
+{
+    auto instance = new klinker::Receiver(settings != nullptr ? *settings : klinker::ReceiverSettings());
+    instance->SetHandle(receiverTable_.Add(instance));
+    instance->Start(klinker::DeviceCatalog::GetInstance().SelectByID(deviceID, mode));
+    return instance;
+}
+
 extern "C" void UNITY_INTERFACE_EXPORT DestroyReceiver(void* receiver)
 {
     auto instance = reinterpret_cast<klinker::Receiver*>(receiver);
     if (instance == nullptr) return;
-    receiverMap_.Remove(instance);
+    receiverTable_.Remove(instance->GetHandle());
     instance->Stop();
     instance->Release();
 }
@@ -94,7 +155,7 @@ extern "C" unsigned int UNITY_INTERFACE_EXPORT GetReceiverID(void* receiver)
 {
     auto instance = reinterpret_cast<klinker::Receiver*>(receiver);
     if (instance == nullptr) return 0;
-    return receiverMap_.GetID(instance);
+    return instance->GetHandle();
 }
 
 extern "C" int UNITY_INTERFACE_EXPORT GetReceiverFrameWidth(void* receiver)
@@ -118,6 +179,13 @@ extern "C" std::int64_t UNITY_INTERFACE_EXPORT GetReceiverFrameDuration(void* re
     return instance->GetFrameDuration();
 }
 
+extern "C" int UNITY_INTERFACE_EXPORT GetReceiverBytesPerPixel(void* receiver)
+{
+    if (receiver == nullptr) return 0;
+    auto instance = reinterpret_cast<klinker::Receiver*>(receiver);
+    return instance->GetBytesPerPixel();
+}
+
 extern "C" int UNITY_INTERFACE_EXPORT IsReceiverProgressive(void* receiver)
 {
     auto instance = reinterpret_cast<klinker::Receiver*>(receiver);
@@ -149,6 +217,13 @@ extern "C" void UNITY_INTERFACE_EXPORT DequeueReceiverFrame(void* receiver)
     instance->DequeueFrame();
 }
 
+extern "C" int UNITY_INTERFACE_EXPORT SelectReceiverFrameForTime(void* receiver, std::int64_t time)
+{
+    if (receiver == nullptr) return -1;
+    auto instance = reinterpret_cast<klinker::Receiver*>(receiver);
+    return instance->SelectFrameForTime(time);
+}
+
 extern "C" unsigned int UNITY_INTERFACE_EXPORT GetReceiverTimecode(void* receiver)
 {
     auto instance = reinterpret_cast<klinker::Receiver*>(receiver);
@@ -156,6 +231,20 @@ extern "C" unsigned int UNITY_INTERFACE_EXPORT GetReceiverTimecode(void* receive
     return instance->GetOldestTimecode();
 }
 
+extern "C" std::int64_t UNITY_INTERFACE_EXPORT GetReceiverStreamTime(void* receiver)
+{
+    if (receiver == nullptr) return 0;
+    auto instance = reinterpret_cast<klinker::Receiver*>(receiver);
+    return instance->GetOldestStreamTime();
+}
+
+extern "C" std::int64_t UNITY_INTERFACE_EXPORT GetReceiverHardwareTime(void* receiver)
+{
+    if (receiver == nullptr) return 0;
+    auto instance = reinterpret_cast<klinker::Receiver*>(receiver);
+    return instance->GetOldestHardwareTime();
+}
+
 extern "C" int UNITY_INTERFACE_EXPORT CountDroppedReceiverFrames(void* receiver)
 {
     if (receiver == nullptr) return 0;
@@ -163,6 +252,69 @@ extern "C" int UNITY_INTERFACE_EXPORT CountDroppedReceiverFrames(void* receiver)
     return instance->CountDroppedFrames();
 }
 
+extern "C" void UNITY_INTERFACE_EXPORT GetReceiverDropCounters(void* receiver, klinker::DropCounters* counters)
+{
+    if (receiver == nullptr || counters == nullptr) return;
+    auto instance = reinterpret_cast<klinker::Receiver*>(receiver);
+    *counters = instance->GetDropCounters();
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT GetReceiverStats(void* receiver, klinker::Statistics* stats)
+{
+    if (receiver == nullptr || stats == nullptr) return;
+    auto instance = reinterpret_cast<klinker::Receiver*>(receiver);
+    *stats = instance->GetStatistics();
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT GetReceiverAllocatorStats(void* receiver, klinker::AllocatorStats* stats)
+{
+    if (receiver == nullptr || stats == nullptr) return;
+    auto instance = reinterpret_cast<klinker::Receiver*>(receiver);
+    *stats = instance->GetAllocatorStats();
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT GetReceiverLatencyStats(void* receiver, klinker::LatencyStats* dequeue, klinker::LatencyStats* upload)
+{
+    if (receiver == nullptr || dequeue == nullptr || upload == nullptr) return;
+    auto instance = reinterpret_cast<klinker::Receiver*>(receiver);
+    instance->GetLatencyStats(*dequeue, *upload);
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT ResetReceiverLatencyStats(void* receiver)
+{
+    if (receiver == nullptr) return;
+    auto instance = reinterpret_cast<klinker::Receiver*>(receiver);
+    instance->ResetLatencyStats();
+}
+
+extern "C" int UNITY_INTERFACE_EXPORT GetReceiverAudioChannelCount(void* receiver)
+{
+    if (receiver == nullptr) return 0;
+    auto instance = reinterpret_cast<klinker::Receiver*>(receiver);
+    return instance->GetAudioChannelCount();
+}
+
+extern "C" int UNITY_INTERFACE_EXPORT CountReceiverAudioFrames(void* receiver)
+{
+    if (receiver == nullptr) return 0;
+    auto instance = reinterpret_cast<klinker::Receiver*>(receiver);
+    return static_cast<int>(instance->CountAudioFrames());
+}
+
+extern "C" std::int64_t UNITY_INTERFACE_EXPORT CountReceiverAudioOverruns(void* receiver)
+{
+    if (receiver == nullptr) return 0;
+    auto instance = reinterpret_cast<klinker::Receiver*>(receiver);
+    return instance->CountAudioOverruns();
+}
+
+extern "C" int UNITY_INTERFACE_EXPORT PullReceiverAudio(void* receiver, float* samples, int frameCount, std::int64_t* streamTime)
+{
+    if (receiver == nullptr || samples == nullptr || frameCount <= 0) return 0;
+    auto instance = reinterpret_cast<klinker::Receiver*>(receiver);
+    return static_cast<int>(instance->PullAudio(samples, frameCount, streamTime));
+}
+
 extern "C" const void UNITY_INTERFACE_EXPORT * GetReceiverError(void* receiver)
 {
     if (receiver == nullptr) return nullptr;
@@ -189,6 +341,48 @@ extern "C" void UNITY_INTERFACE_EXPORT * CreateManualSender(int device, int form
     return instance;
 }
 
+extern "C" void UNITY_INTERFACE_EXPORT * CreateAsyncSenderWithSettings(int device, int format, int preroll, const klinker::SenderSettings* settings)
+{
+    auto instance = new klinker::Sender(settings != nullptr ? *settings : klinker::SenderSettings());
+    instance->StartAsyncMode(device, format, preroll);
+    return instance;
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT * CreateManualSenderWithSettings(int device, int format, const klinker::SenderSettings* settings)
+{
+    auto instance = new klinker::Sender(settings != nullptr ? *settings : klinker::SenderSettings());
+    instance->StartManualMode(device, format);
+    return instance;
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT * CreateAsyncSenderByID(std::int64_t deviceID, std::uint32_t mode, int preroll)
+{
+    auto instance = new klinker::Sender();
+    instance->StartAsyncMode(klinker::DeviceCatalog::GetInstance().SelectByID(deviceID, mode), preroll);
+    return instance;
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT * CreateManualSenderByID(std::int64_t deviceID, std::uint32_t mode)
+{
+    auto instance = new klinker::Sender();
+    instance->StartManualMode(klinker::DeviceCatalog::GetInstance().SelectByID(deviceID, mode));
+    return instance;
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT * CreateAsyncSenderByIDWithSettings(std::int64_t deviceID, std::uint32_t mode, int preroll, const klinker::SenderSettings* settings)
+{
+    auto instance = new klinker::Sender(settings != nullptr ? *settings : klinker::SenderSettings());
+    instance->StartAsyncMode(klinker::DeviceCatalog::GetInstance().SelectByID(deviceID, mode), preroll);
+    return instance;
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT * CreateManualSenderByIDWithSettings(std::int64_t deviceID, std::uint32_t mode, const klinker::SenderSettings* settings)
+{
+    auto instance = new klinker::Sender(settings != nullptr ? *settings : klinker::SenderSettings());
+    instance->StartManualMode(klinker::DeviceCatalog::GetInstance().SelectByID(deviceID, mode));
+    return instance;
+}
+
 extern "C" void UNITY_INTERFACE_EXPORT DestroySender(void* sender)
 {
     if (sender == nullptr) return;
@@ -232,11 +426,67 @@ extern "C" int UNITY_INTERFACE_EXPORT IsSenderReferenceLocked(void* sender)
     return instance->IsReferenceLocked() ? 1 : 0;
 }
 
-extern "C" void UNITY_INTERFACE_EXPORT FeedFrameToSender(void* sender, void* frameData, unsigned int timecode)
+extern "C" std::int64_t UNITY_INTERFACE_EXPORT FeedFrameToSender(void* sender, void* frameData, unsigned int timecode)
+{
+    if (sender == nullptr) return 0;
+    auto instance = reinterpret_cast<klinker::Sender*>(sender);
+    return instance->FeedFrame(frameData, timecode);
+}
+
+extern "C" std::int64_t UNITY_INTERFACE_EXPORT GetSenderCompletedFeedCount(void* sender)
+{
+    if (sender == nullptr) return 0;
+    auto instance = reinterpret_cast<klinker::Sender*>(sender);
+    return instance->GetCompletedFeedCount();
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT WaitSenderFeedCompletion(void* sender, std::int64_t ticket)
 {
     if (sender == nullptr) return;
     auto instance = reinterpret_cast<klinker::Sender*>(sender);
-    instance->FeedFrame(frameData, timecode);
+    instance->WaitFeedCompletion(ticket);
+}
+
+extern "C" int UNITY_INTERFACE_EXPORT GetSenderFrameRowBytes(void* sender)
+{
+    if (sender == nullptr) return 0;
+    auto instance = reinterpret_cast<klinker::Sender*>(sender);
+    return static_cast<int>(instance->GetFrameRowBytes());
+}
+
+extern "C" int UNITY_INTERFACE_EXPORT GetSenderInputRowBytes(void* sender)
+{
+    if (sender == nullptr) return 0;
+    auto instance = reinterpret_cast<klinker::Sender*>(sender);
+    return static_cast<int>(instance->GetInputRowBytes());
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT * AcquireSenderFrameBuffer(void* sender)
+{
+    if (sender == nullptr) return nullptr;
+    auto instance = reinterpret_cast<klinker::Sender*>(sender);
+    return instance->AcquireFrameBuffer();
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT CommitSenderFrame(void* sender, unsigned int timecode)
+{
+    if (sender == nullptr) return;
+    auto instance = reinterpret_cast<klinker::Sender*>(sender);
+    instance->CommitFrame(timecode);
+}
+
+extern "C" int UNITY_INTERFACE_EXPORT PushSenderAudio(void* sender, const float* samples, int frameCount)
+{
+    if (sender == nullptr || samples == nullptr || frameCount <= 0) return 0;
+    auto instance = reinterpret_cast<klinker::Sender*>(sender);
+    return instance->PushAudio(samples, frameCount) ? 1 : 0;
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT GetSenderAudioStats(void* sender, klinker::AudioOutputStats* stats)
+{
+    if (sender == nullptr || stats == nullptr) return;
+    auto instance = reinterpret_cast<klinker::Sender*>(sender);
+    *stats = instance->GetAudioStats();
 }
 
 extern "C" void UNITY_INTERFACE_EXPORT WaitSenderCompletion(void* sender, std::int64_t frameNumber)
@@ -246,6 +496,62 @@ extern "C" void UNITY_INTERFACE_EXPORT WaitSenderCompletion(void* sender, std::i
     instance->WaitFrameCompletion(frameNumber);
 }
 
+extern "C" int UNITY_INTERFACE_EXPORT WaitSenderCompletionWithTimeout(void* sender, std::int64_t frameNumber, int timeout)
+{
+    if (sender == nullptr) return 0;
+    auto instance = reinterpret_cast<klinker::Sender*>(sender);
+    return instance->WaitFrameCompletion(frameNumber, timeout) ? 1 : 0;
+}
+
+extern "C" std::int64_t UNITY_INTERFACE_EXPORT GetSenderCompletedFrameCount(void* sender)
+{
+    if (sender == nullptr) return 0;
+    auto instance = reinterpret_cast<klinker::Sender*>(sender);
+    return instance->GetCompletedFrameCount();
+}
+
+extern "C" int UNITY_INTERFACE_EXPORT StartSenderPlayback(void* sender)
+{
+    if (sender == nullptr) return 0;
+    auto instance = reinterpret_cast<klinker::Sender*>(sender);
+    return instance->StartPlayback() ? 1 : 0;
+}
+
+extern "C" std::int64_t UNITY_INTERFACE_EXPORT CountSenderRecoveries(void* sender)
+{
+    if (sender == nullptr) return 0;
+    auto instance = reinterpret_cast<klinker::Sender*>(sender);
+    return instance->CountRecoveries();
+}
+
+extern "C" std::int64_t UNITY_INTERFACE_EXPORT CountSenderWaitTimeouts(void* sender)
+{
+    if (sender == nullptr) return 0;
+    auto instance = reinterpret_cast<klinker::Sender*>(sender);
+    return instance->CountWaitTimeouts();
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT SetSenderCompletionFence(void* sender, std::int64_t frameNumber)
+{
+    if (sender == nullptr) return;
+    auto instance = reinterpret_cast<klinker::Sender*>(sender);
+    instance->SetCompletionFence(frameNumber);
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT SetSenderCompletionCallback(void* sender, klinker::CompletionCallback callback, void* userData)
+{
+    if (sender == nullptr) return;
+    auto instance = reinterpret_cast<klinker::Sender*>(sender);
+    instance->SetCompletionCallback(callback, userData);
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT * GetSenderCompletionEvent(void* sender)
+{
+    if (sender == nullptr) return nullptr;
+    auto instance = reinterpret_cast<klinker::Sender*>(sender);
+    return instance->GetCompletionEvent();
+}
+
 extern "C" const int UNITY_INTERFACE_EXPORT CountDroppedSenderFrames(void* sender)
 {
     if (sender == nullptr) return 0;
@@ -253,6 +559,34 @@ extern "C" const int UNITY_INTERFACE_EXPORT CountDroppedSenderFrames(void* sende
     return instance->CountDroppedFrames();
 }
 
+extern "C" void UNITY_INTERFACE_EXPORT GetSenderStats(void* sender, klinker::Statistics* stats)
+{
+    if (sender == nullptr || stats == nullptr) return;
+    auto instance = reinterpret_cast<klinker::Sender*>(sender);
+    *stats = instance->GetStatistics();
+}
+
+extern "C" int UNITY_INTERFACE_EXPORT GetSenderPrerollDepth(void* sender)
+{
+    if (sender == nullptr) return 0;
+    auto instance = reinterpret_cast<klinker::Sender*>(sender);
+    return instance->GetPrerollDepth();
+}
+
+extern "C" int UNITY_INTERFACE_EXPORT CountSenderBufferedFrames(void* sender)
+{
+    if (sender == nullptr) return 0;
+    auto instance = reinterpret_cast<klinker::Sender*>(sender);
+    return instance->CountBufferedFrames();
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT GetSenderFramePoolStats(void* sender, klinker::FramePoolStats* stats)
+{
+    if (sender == nullptr || stats == nullptr) return;
+    auto instance = reinterpret_cast<klinker::Sender*>(sender);
+    *stats = instance->GetFramePoolStats();
+}
+
 extern "C" const void UNITY_INTERFACE_EXPORT * GetSenderError(void* sender)
 {
     if (sender == nullptr) return nullptr;
@@ -262,3 +596,84 @@ extern "C" const void UNITY_INTERFACE_EXPORT * GetSenderError(void* sender)
 }
 
 #pragma endregion
+
+#pragma region Sender group functions
+
+extern "C" void UNITY_INTERFACE_EXPORT * CreateSenderGroup()
+{
+    return new klinker::SenderGroup();
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT DestroySenderGroup(void* group)
+{
+    if (group == nullptr) return;
+    auto instance = reinterpret_cast<klinker::SenderGroup*>(group);
+    delete instance;
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT AddSenderToGroup(void* group, void* sender)
+{
+    if (group == nullptr || sender == nullptr) return;
+    auto instance = reinterpret_cast<klinker::SenderGroup*>(group);
+    instance->Add(reinterpret_cast<klinker::Sender*>(sender));
+}
+
+extern "C" int UNITY_INTERFACE_EXPORT StartSenderGroup(void* group)
+{
+    if (group == nullptr) return 0;
+    auto instance = reinterpret_cast<klinker::SenderGroup*>(group);
+    return instance->Start() ? 1 : 0;
+}
+
+extern "C" std::int64_t UNITY_INTERFACE_EXPORT GetSenderGroupPhaseDrift(void* group, int index)
+{
+    if (group == nullptr) return 0;
+    auto instance = reinterpret_cast<klinker::SenderGroup*>(group);
+    return instance->GetPhaseDrift(index);
+}
+
+#pragma endregion
+
+#pragma region Color conversion functions
+
+namespace
+{
+    // Shared color converter
+    // It's intentionally leaked to avoid joining the worker threads while
+    // the DLL is being unloaded (under the loader lock).
+    klinker::ColorConverter& GetColorConverter()
+    {
+        static auto instance = new klinker::ColorConverter();
+        return *instance;
+    }
+}
+
+extern "C" void UNITY_INTERFACE_EXPORT ConvertUYVYFrame(
+    const void* source, int sourceRowBytes,
+    void* dest, int destRowBytes, int width, int height,
+    int format, int field, int linear
+)
+{
+    if (source == nullptr || dest == nullptr) return;
+    GetColorConverter().Convert(
+        source, sourceRowBytes, dest, destRowBytes, width, height,
+        static_cast<klinker::ConvertFormat>(format),
+        static_cast<klinker::FieldMode>(field), linear != 0
+    );
+}
+
+extern "C" int UNITY_INTERFACE_EXPORT ConvertReceiverFrame(
+    void* receiver, void* dest, int destRowBytes,
+    int format, int field, int linear
+)
+{
+    if (receiver == nullptr || dest == nullptr) return 0;
+    auto instance = reinterpret_cast<klinker::Receiver*>(receiver);
+    return instance->ConvertOldestFrame(
+        GetColorConverter(), dest, destRowBytes,
+        static_cast<klinker::ConvertFormat>(format),
+        static_cast<klinker::FieldMode>(field), linear != 0
+    ) ? 1 : 0;
+}
+
+#pragma endregion
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "Common.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+namespace klinker
+{
+    //
+    // Latency statistics
+    //
+    // Plain data structure passed to the managed side. The layout should be
+    // kept in sync with ReceiverPlugin.LatencyStats. All values are in
+    // microseconds.
+    //
+    struct LatencyStats
+    {
+        std::int64_t count;
+        std::int64_t mean;
+        std::int64_t p50;
+        std::int64_t p90;
+        std::int64_t p99;
+        std::int64_t max;
+    };
+
+    //
+    // Latency histogram class
+    //
+    // HDR-style log-linear histogram of microsecond values: Values below 32
+    // have their own buckets, and each power-of-two range above it is split
+    // into 16 buckets (about 6% precision). Recording is a few relaxed
+    // atomic operations, so it can be done on any thread while the stats are
+    // read on another.
+    //
+    class LatencyHistogram final
+    {
+    public:
+
+        // Monotonic host clock in microseconds
+        static std::int64_t GetHostTime()
+        {
+            using namespace std::chrono;
+            auto t = steady_clock::now().time_since_epoch();
+            return duration_cast<microseconds>(t).count();
+        }
+
+        void Record(std::int64_t microseconds)
+        {
+            auto value = static_cast<std::uint64_t>(microseconds < 0 ? 0 : microseconds);
+            buckets_[GetBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+            count_.fetch_add(1, std::memory_order_relaxed);
+            sum_.fetch_add(value, std::memory_order_relaxed);
+
+            auto max = max_.load(std::memory_order_relaxed);
+            while (value > max && !max_.compare_exchange_weak(max, value)) {}
+        }
+
+        void Reset()
+        {
+            for (auto& b : buckets_) b.store(0, std::memory_order_relaxed);
+            count_ = sum_ = max_ = 0;
+        }
+
+        // Note that the result is not an atomic snapshot; It might be
+        // slightly inconsistent while recording.
+        LatencyStats GetStats() const
+        {
+            LatencyStats stats = {};
+
+            std::uint64_t counts[bucketCount_];
+            std::uint64_t total = 0;
+
+            for (auto i = 0; i < bucketCount_; i++)
+                total += counts[i] = buckets_[i].load(std::memory_order_relaxed);
+
+            if (total == 0) return stats;
+
+            stats.count = static_cast<std::int64_t>(total);
+            stats.mean = static_cast<std::int64_t>(sum_.load() / std::max<std::uint64_t>(count_.load(), 1));
+            stats.p50 = GetPercentile(counts, total, 50);
+            stats.p90 = GetPercentile(counts, total, 90);
+            stats.p99 = GetPercentile(counts, total, 99);
+            stats.max = static_cast<std::int64_t>(max_.load());
+
+            return stats;
+        }
+
+    private:
+
+        static const int linearCount_ = 32;
+        static const int subBucketCount_ = 16;
+        static const int bucketCount_ = linearCount_ + (32 - 5) * subBucketCount_;
+
+        std::atomic<std::uint32_t> buckets_[bucketCount_] = {};
+        std::atomic<std::uint64_t> count_ = 0;
+        std::atomic<std::uint64_t> sum_ = 0;
+        std::atomic<std::uint64_t> max_ = 0;
+
+        static int GetBucketIndex(std::uint64_t value)
+        {
+            if (value < linearCount_) return static_cast<int>(value);
+
+            // Clamp to the range (about 71 minutes).
+            if (value > 0xffffffffU) value = 0xffffffffU;
+
+            // Most significant bit (5-31)
+            auto msb = 5;
+            while ((value >> (msb + 1)) != 0) msb++;
+
+            auto sub = static_cast<int>(value >> (msb - 4)) - subBucketCount_;
+            return linearCount_ + (msb - 5) * subBucketCount_ + sub;
+        }
+
+        // Representative value (the middle) of a bucket
+        static std::int64_t GetBucketValue(int index)
+        {
+            if (index < linearCount_) return index;
+
+            auto msb = 5 + (index - linearCount_) / subBucketCount_;
+            auto sub = (index - linearCount_) % subBucketCount_ + subBucketCount_;
+            auto width = std::int64_t(1) << (msb - 4);
+            return sub * width + width / 2;
+        }
+
+        static std::int64_t GetPercentile(const std::uint64_t* counts, std::uint64_t total, int percent)
+        {
+            auto threshold = (total * percent + 99) / 100;
+            std::uint64_t accum = 0;
+            for (auto i = 0; i < bucketCount_; i++)
+            {
+                accum += counts[i];
+                if (accum >= threshold) return GetBucketValue(i);
+            }
+            return GetBucketValue(bucketCount_ - 1);
+        }
+    };
+}
@@ -0,0 +1,196 @@
+#pragma once
+
+#include "Common.h"
+#include <atomic>
+#include <memory>
+
+namespace klinker
+{
+    //
+    // Output frame pool statistics
+    //
+    // Plain data structure passed to the managed side. The layout should be
+    // kept in sync with SenderPlugin.FramePoolStats.
+    //
+    struct FramePoolStats
+    {
+        std::int64_t acquired;  // Total number of acquired frames
+        std::int64_t exhausted; // Acquisitions that fell back to allocation
+        std::int32_t poolSize;  // Number of the pooled frames
+        std::int32_t inUse;     // Pooled frames currently in use
+        std::int32_t peakInUse; // High-water mark of inUse
+    };
+
+    //
+    // Output frame pool class
+    //
+    // A fixed set of preallocated output frames that are recycled instead of
+    // creating a new frame for each output. A pooled frame has a use count:
+    // The owner holds one use, and each pending schedule holds one use. The
+    // frame goes back to the pool when the count reaches zero (e.g. in the
+    // completion callback).
+    //
+    // When the pool runs dry, it falls back to allocating a one-shot frame
+    // and records it as back-pressure. One-shot frames are managed with the
+    // COM reference count, so the same Retain/Release calls work for them.
+    //
+    // Acquire/Retain/Release are lock-free and can be called from any
+    // thread. Allocate/Reset are not thread safe.
+    //
+    class OutputFramePool final
+    {
+    public:
+
+        #pragma region Constructor/destructor
+
+        ~OutputFramePool()
+        {
+            Reset();
+        }
+
+        #pragma endregion
+
+        #pragma region Setup methods
+
+        bool Allocate(
+            IDeckLinkOutput* output, int count,
+            long width, long height, long rowBytes, BMDPixelFormat format
+        )
+        {
+            Reset();
+
+            output_ = output;
+            width_ = width;
+            height_ = height;
+            rowBytes_ = rowBytes;
+            format_ = format;
+
+            entries_.reset(new Entry[count]);
+            count_ = count;
+
+            for (auto i = 0; i < count; i++)
+            {
+                entries_[i].frame = CreateFrame();
+                if (entries_[i].frame == nullptr) return false;
+            }
+
+            return true;
+        }
+
+        // Release all the pooled frames. It should be called after the
+        // output is stopped (the frames are not referenced by the driver).
+        void Reset()
+        {
+            for (auto i = 0; i < count_; i++)
+                if (entries_[i].frame != nullptr) entries_[i].frame->Release();
+
+            entries_.reset();
+            count_ = 0;
+            output_ = nullptr;
+
+            acquired_ = exhausted_ = 0;
+            inUse_ = peakInUse_ = 0;
+        }
+
+        #pragma endregion
+
+        #pragma region Frame methods
+
+        // Acquire a frame with one use held by the caller.
+        IDeckLinkMutableVideoFrame* Acquire()
+        {
+            acquired_++;
+
+            for (auto i = 0; i < count_; i++)
+            {
+                auto& entry = entries_[i];
+                auto free = 0;
+                if (!entry.uses.compare_exchange_strong(free, 1)) continue;
+
+                auto inUse = ++inUse_;
+                auto peak = peakInUse_.load();
+                while (inUse > peak && !peakInUse_.compare_exchange_weak(peak, inUse)) {}
+
+                return entry.frame;
+            }
+
+            // Pool exhausted: Allocate a one-shot frame.
+            DebugLog("Output frame pool exhausted.");
+            exhausted_++;
+            return CreateFrame();
+        }
+
+        // Add a use to a frame.
+        void Retain(IDeckLinkVideoFrame* frame)
+        {
+            auto entry = Find(frame);
+            if (entry != nullptr)
+                entry->uses++;
+            else
+                frame->AddRef();
+        }
+
+        // Remove a use from a frame.
+        void Release(IDeckLinkVideoFrame* frame)
+        {
+            auto entry = Find(frame);
+            if (entry == nullptr)
+                frame->Release();
+            else if (entry->uses-- == 1)
+                inUse_--;
+        }
+
+        FramePoolStats GetStats() const
+        {
+            FramePoolStats stats;
+            stats.acquired = acquired_;
+            stats.exhausted = exhausted_;
+            stats.poolSize = count_;
+            stats.inUse = inUse_;
+            stats.peakInUse = peakInUse_;
+            return stats;
+        }
+
+        #pragma endregion
+
+    private:
+
+        #pragma region Private members
+
+        struct Entry
+        {
+            IDeckLinkMutableVideoFrame* frame = nullptr;
+            std::atomic<int> uses = 0;
+        };
+
+        std::unique_ptr<Entry[]> entries_;
+        int count_ = 0;
+
+        IDeckLinkOutput* output_ = nullptr;
+        long width_ = 0, height_ = 0, rowBytes_ = 0;
+        BMDPixelFormat format_ = bmdFormat8BitYUV;
+
+        std::atomic<std::int64_t> acquired_ = 0;
+        std::atomic<std::int64_t> exhausted_ = 0;
+        std::atomic<std::int32_t> inUse_ = 0;
+        std::atomic<std::int32_t> peakInUse_ = 0;
+
+        Entry* Find(IDeckLinkVideoFrame* frame) const
+        {
+            for (auto i = 0; i < count_; i++)
+                if (entries_[i].frame == frame) return &entries_[i];
+            return nullptr;
+        }
+
+        IDeckLinkMutableVideoFrame* CreateFrame() const
+        {
+            IDeckLinkMutableVideoFrame* frame = nullptr;
+            auto res = output_->CreateVideoFrame(
+                width_, height_, rowBytes_, format_, bmdFrameFlagDefault, &frame
+            );
+            return res == S_OK ? frame : nullptr;
+        }
+
+        #pragma endregion
+    };
+}
@@ -1,20 +1,110 @@
 #pragma once
 
 #include "Common.h"
+#include "AudioRing.h"
+#include "ColorConverter.h"
+#include "DeviceCatalog.h"
+#include "FrameAllocator.h"
+#include "FramePool.h"
+#include "FrameQueue.h"
+#include "LatencyHistogram.h"
+#include "Statistics.h"
+#include "V210Unpacker.h"
+#include <algorithm>
 #include <atomic>
+#include <cstring>
 #include <mutex>
-#include <queue>
+#include <thread>
 #include <tuple>
 #include <vector>
 
 namespace klinker
 {
+    //
+    // Frame queue overflow policies
+    //
+    enum class OverflowPolicy : int
+    {
+        DropNewest, // Drop the arrived frame.
+        DropOldest, // Drop the oldest queued frame.
+        Mailbox     // Keep only the latest frame.
+    };
+
+    //
+    // Capture pixel formats
+    //
+    enum class CaptureFormat : int
+    {
+        YUV8, // 8-bit 4:2:2 (UYVY)
+        YUV10 // 10-bit 4:2:2 (v210), unpacked into half-precision UYVY
+    };
+
+    //
+    // Frame drop counters
+    //
+    // Plain data structure passed to the managed side. The layout should be
+    // kept in sync with ReceiverPlugin.DropCounters.
+    //
+    struct DropCounters
+    {
+        std::int32_t newest;     // Arrived frames dropped (DropNewest)
+        std::int32_t oldest;     // Queued frames dropped (DropOldest)
+        std::int32_t superseded; // Frames replaced by newer ones (Mailbox)
+        std::int32_t overqueue;  // Frames skipped on frame selection
+        std::int32_t underrun;   // Frame selection underruns
+        std::int32_t pinned;     // Arrived frames dropped on a slot in use
+    };
+
+    //
+    // Receiver settings
+    //
+    // Plain data structure passed from the managed side. The layout should
+    // be kept in sync with ReceiverPlugin.Settings.
+    //
+    struct ReceiverSettings
+    {
+        // Maximum number of input frames retained without copying.
+        // Zero disables the zero-copy mode.
+        int maxRetainedFrames = 0;
+
+        // Nonzero to install the plugin-owned frame memory allocator.
+        int useFrameAllocator = 0;
+
+        // Nonzero to back the frame allocator with large pages.
+        int useLargePages = 0;
+
+        // Length of the frame queue. Zero or less selects the default.
+        int queueDepth = 0;
+
+        // Number of the frames to be queued before presentation (used in
+        // SelectFrameForTime). Zero disables prerolling. Negative selects
+        // the default. It's limited to what the queue can hold.
+        int prerollLength = -1;
+
+        // What to do when a frame arrives while the queue is full
+        OverflowPolicy overflowPolicy = OverflowPolicy::DropNewest;
+
+        // Pixel format of the input stream
+        CaptureFormat captureFormat = CaptureFormat::YUV8;
+
+        // Number of the audio channels to capture (2, 8 or 16).
+        // Zero disables the audio input.
+        int audioChannelCount = 0;
+
+        // Audio sample depth: 32 selects 32-bit, otherwise 16-bit.
+        int audioSampleDepth = 16;
+    };
+
     //
     // Frame receiver class
     //
-    // Arrived frames will be stored in an internal queue that is only used to
-    // avoid frame dropping. Frame rate matching should be done on the
-    // application side.
+    // Arrived frames will be stored in an internal queue that absorbs the
+    // jitter between the input and the application. Frame rate matching is
+    // done by SelectFrameForTime, which the application calls once a frame.
+    //
+    // Frame buffers are recycled through a preallocated pool and a lock-free
+    // queue, so the callback thread neither allocates nor waits for the
+    // render thread. Embedded audio is captured along with the frames.
     //
     class Receiver final : private IDeckLinkInputCallback
     {
@@ -22,11 +112,26 @@ namespace klinker
 
         #pragma region Constructor/destructor
 
+        Receiver(const ReceiverSettings& settings = ReceiverSettings())
+          : settings_(settings)
+        {
+            if (settings_.queueDepth <= 0) settings_.queueDepth = defaultQueueDepth_;
+            if (settings_.prerollLength < 0) settings_.prerollLength = defaultPrerollLength_;
+
+            // A mailbox holds only one frame, so it can't be prerolled.
+            if (settings_.overflowPolicy == OverflowPolicy::Mailbox) settings_.prerollLength = 0;
+            settings_.prerollLength = std::min(settings_.prerollLength, settings_.queueDepth - 1);
+        }
+
         ~Receiver()
         {
             // Internal objects should have been released.
             assert(input_ == nullptr);
             assert(displayMode_ == nullptr);
+
+            // Deferred cleanup (see Stop)
+            ReleaseFrameBuffers();
+            if (allocator_ != nullptr) allocator_->Release();
         }
 
         #pragma endregion
@@ -56,8 +161,20 @@ namespace klinker
         std::size_t CalculateFrameDataSize() const
         {
             assert(displayMode_ != nullptr);
-            return (std::size_t)2 *
-                displayMode_->GetWidth() * displayMode_->GetHeight();
+            return CalculateFrameDataSize(
+                displayMode_->GetWidth(), displayMode_->GetHeight()
+            );
+        }
+
+        std::size_t CalculateFrameDataSize(long width, long height) const
+        {
+            // Bytes per pixel: UYVY = 2, half-precision UYVY = 4
+            return (std::size_t)GetBytesPerPixel() * width * height;
+        }
+
+        int GetBytesPerPixel() const
+        {
+            return settings_.captureFormat == CaptureFormat::YUV10 ? 4 : 2;
         }
 
         BSTR RetrieveFormatName() const
@@ -71,7 +188,45 @@ namespace klinker
 
         int CountDroppedFrames() const
         {
-            return dropCount_;
+            // Mailbox replacements are not counted as they're intended.
+            auto c = stats_.GetCounters();
+            return static_cast<int>(c.dropsNewest + c.dropsOldest + c.dropsOverqueue + c.dropsUnderrun + c.dropsPinned);
+        }
+
+        DropCounters GetDropCounters() const
+        {
+            auto c = stats_.GetCounters();
+            DropCounters drops;
+            drops.newest = static_cast<std::int32_t>(c.dropsNewest);
+            drops.oldest = static_cast<std::int32_t>(c.dropsOldest);
+            drops.superseded = static_cast<std::int32_t>(c.dropsSuperseded);
+            drops.overqueue = static_cast<std::int32_t>(c.dropsOverqueue);
+            drops.underrun = static_cast<std::int32_t>(c.dropsUnderrun);
+            drops.pinned = static_cast<std::int32_t>(c.dropsPinned);
+            return drops;
+        }
+
+        // Consistent snapshot of the statistics (any thread)
+        Statistics GetStatistics() const
+        {
+            return stats_.GetSnapshot();
+        }
+
+        AllocatorStats GetAllocatorStats() const
+        {
+            if (allocator_ == nullptr) return {};
+            return allocator_->GetStats();
+        }
+
+        // Handle used to identify the instance on the render thread
+        std::uint32_t GetHandle() const
+        {
+            return handle_;
+        }
+
+        void SetHandle(std::uint32_t handle)
+        {
+            handle_ = handle;
         }
 
         const std::string& GetErrorString() const
@@ -85,42 +240,214 @@ namespace klinker
 
         std::size_t CountQueuedFrames() const
         {
-            return frameQueue_.size();
+            return frameQueue_.CountQueued();
         }
 
         void DequeueFrame()
         {
-            std::lock_guard<std::mutex> lock(mutex_);
-            if (!frameQueue_.empty()) frameQueue_.pop();
+            // Pin the slot to read the arrival time safely.
+            auto frame = frameQueue_.Pin(dequeueReader_);
+            if (frame == nullptr) return;
+
+            dequeueLatency_.Record(LatencyHistogram::GetHostTime() - frame->arrivalTime_);
+
+            // Pop the pinned slot and take over its retained frame. It might
+            // have been discarded by the producer in the meantime.
+            std::size_t index;
+            if (frameQueue_.PopPinned(dequeueReader_, &index))
+            {
+                RetireFrame(index, consumerRetired_);
+                stats_.Update([](StatisticsRecorder::Counters& c) { c.framesOut++; });
+            }
+
+            frameQueue_.Unpin(dequeueReader_);
+
+            // Give back the retired frames that are no longer pinned.
+            ReleaseRetiredFrames(consumerRetired_);
         }
 
-        const uint8_t* LockOldestFrameData()
+        // Frame rate matching: Advance the presentation time and dequeue
+        // the frames that have been already presented. It also handles
+        // prerolling, overqueuing (skipping stale frames) and underruns.
+        // Should be called once per application frame from a single thread.
+        //
+        // Returns the field to be presented with the oldest frame: 0 (odd
+        // field or progressive), 1 (even field), or -1 (not ready).
+        int SelectFrameForTime(std::int64_t time)
         {
-            mutex_.lock();
+            // Time elapsed from the last call
+            auto delta = selection_.started ? time - selection_.lastTime : 0;
+            selection_.lastTime = time;
+            selection_.started = true;
+
+            // At least it should have one frame in the queue.
+            if (frameQueue_.CountQueued() == 0) return -1;
 
-            if (!frameQueue_.empty())
+            // Prerolling
+            std::size_t length = settings_.prerollLength;
+            if (!selection_.prerolled)
             {
-                return frameQueue_.front().image_.data();
+                if (frameQueue_.CountQueued() < 1 + length) return -1;
+                selection_.prerolled = true;
             }
-            else
+
+            // Overqueuing detection and recovery
+            auto maxQueue = length + std::max<std::size_t>(1, std::min<std::size_t>(3, length));
+            while (frameQueue_.CountQueued() > maxQueue)
             {
-                mutex_.unlock(); // Unlock before fail return
-                return nullptr;
+                DequeueFrame();
+                stats_.Update([](StatisticsRecorder::Counters& c) { c.dropsOverqueue++; });
             }
+
+            // Advance the frame time.
+            selection_.frameTime += delta;
+
+            // Frame duration (the display mode can be changed at any time)
+            std::int64_t duration;
+            {
+                auto lock = stats_.Lock(mutex_);
+                duration = GetFrameDuration();
+            }
+
+            // Move to the even field.
+            auto field = 1;
+
+            // Dequeue the frames that are in the previous frame duration.
+            while (selection_.frameTime >= duration)
+            {
+                // Only the current frame is left.
+                if (frameQueue_.CountQueued() < 2)
+                {
+                    if (length == 0)
+                    {
+                        // Without prerolling, keep presenting it until the
+                        // next one arrives.
+                        auto blocking = settings_.overflowPolicy == OverflowPolicy::DropNewest &&
+                            frameQueue_.CountQueued() >= static_cast<std::size_t>(settings_.queueDepth);
+
+                        if (!blocking)
+                        {
+                            selection_.frameTime = duration;
+                            break;
+                        }
+
+                        // The producer can't push the next one with the
+                        // queue full (DropNewest): Discard it to make room.
+                        DequeueFrame();
+                        selection_.frameTime = 0;
+                        stats_.Update([](StatisticsRecorder::Counters& c) { c.dropsUnderrun++; });
+                        return -1;
+                    }
+
+                    // Restart from prerolling.
+                    selection_.prerolled = false;
+                    stats_.Update([](StatisticsRecorder::Counters& c) { c.dropsUnderrun++; });
+                    break;
+                }
+
+                DequeueFrame();
+                selection_.frameTime -= duration;
+
+                // Move back to the odd field.
+                field = 0;
+            }
+
+            return field;
+        }
+
+        const uint8_t* LockOldestFrameData()
+        {
+            auto frame = frameQueue_.Pin(uploadReader_);
+            if (frame == nullptr) return nullptr;
+            uploadLatency_.Record(LatencyHistogram::GetHostTime() - frame->arrivalTime_);
+            return frame->image_;
         }
 
         void UnlockOldestFrameData()
         {
-            mutex_.unlock();
+            frameQueue_.Unpin(uploadReader_);
         }
 
-        std::uint32_t GetOldestTimecode() const
+        // Convert the oldest frame into RGB on the CPU. Returns false when
+        // the queue is empty or the capture format is not supported (only
+        // 8-bit UYVY frames can be converted).
+        bool ConvertOldestFrame(
+            ColorConverter& converter, void* dest, std::size_t destRowBytes,
+            ConvertFormat format, FieldMode field, bool linear
+        )
         {
-            std::lock_guard<std::mutex> lock(mutex_);
-            if (!frameQueue_.empty())
-                return frameQueue_.front().timecode_;
-            else
-                return 0xffffffffU;
+            if (settings_.captureFormat != CaptureFormat::YUV8) return false;
+
+            auto frame = frameQueue_.Pin(converterReader_);
+            if (frame == nullptr) return false;
+
+            converter.Convert(
+                frame->image_, (std::size_t)2 * frame->width_,
+                dest, destRowBytes, frame->width_, frame->height_,
+                format, field, linear
+            );
+
+            frameQueue_.Unpin(converterReader_);
+            return true;
+        }
+
+        std::uint32_t GetOldestTimecode()
+        {
+            FrameData frame;
+            return CopyOldestFrame(frame) ? frame.timecode_ : 0xffffffffU;
+        }
+
+        // Stream time of the oldest frame in flicks
+        std::int64_t GetOldestStreamTime()
+        {
+            FrameData frame;
+            return CopyOldestFrame(frame) ? frame.streamTime_ : AudioRing::noTime;
+        }
+
+        // Hardware reference timestamp of the oldest frame in flicks
+        std::int64_t GetOldestHardwareTime()
+        {
+            FrameData frame;
+            return CopyOldestFrame(frame) ? frame.hardwareTime_ : AudioRing::noTime;
+        }
+
+        void GetLatencyStats(LatencyStats& dequeue, LatencyStats& upload) const
+        {
+            dequeue = dequeueLatency_.GetStats();
+            upload = uploadLatency_.GetStats();
+        }
+
+        void ResetLatencyStats()
+        {
+            dequeueLatency_.Reset();
+            uploadLatency_.Reset();
+        }
+
+        #pragma endregion
+
+        #pragma region Audio methods
+
+        int GetAudioChannelCount() const
+        {
+            return audioRing_.GetChannelCount();
+        }
+
+        std::size_t CountAudioFrames() const
+        {
+            return audioRing_.CountReadable();
+        }
+
+        std::int64_t CountAudioOverruns() const
+        {
+            return audioRing_.CountOverruns();
+        }
+
+        // Pull interleaved samples from the audio ring. This doesn't
+        // allocate memory, so it can be called from an audio callback.
+        // Returns the number of the sample frames pulled.
+        std::size_t PullAudio(float* dest, std::size_t frameCount, std::int64_t* streamTime)
+        {
+            return audioRing_.Read(dest, frameCount, streamTime);
         }
 
         #pragma endregion
@@ -128,11 +455,39 @@ namespace klinker
         #pragma region Public methods
 
         void Start(int deviceIndex, int formatIndex)
+        {
+            Start(DeviceCatalog::GetInstance().SelectInput(deviceIndex, formatIndex));
+        }
+
+        // The device reference in the selection is consumed.
+        void Start(const DeviceSelection& selection)
         {
             assert(input_ == nullptr);
             assert(displayMode_ == nullptr);
 
-            if (!InitializeInput(deviceIndex, formatIndex)) return;
+            // A receiver without a handle can't be found on the render
+            // thread (the handle table was full on creation).
+            if (handle_ == 0)
+            {
+                if (selection.device != nullptr) selection.device->Release();
+                error_ = "Too many receivers.";
+                return;
+            }
+
+            if (!InitializeInput(selection)) return;
+
+            // Frame queue allocation
+            // Extra slots are reserved for the ones pinned by the readers
+            // after being popped.
+            frameQueue_.Reset(settings_.queueDepth + FrameQueue<FrameData>::maxReaders);
+            ResetFrameBuffers(CalculateFrameDataSize());
+
+            // The retired frame lists can't grow beyond the retained frames.
+            consumerRetired_.reserve(settings_.maxRetainedFrames);
+            producerRetired_.reserve(settings_.maxRetainedFrames);
+
+            // Audio ring allocation
+            audioRing_.Reset(settings_.audioChannelCount, audioRingLength_, audioSampleRate_);
 
             ShouldOK(input_->StartStreams());
         }
@@ -144,7 +499,20 @@ namespace klinker
             {
                 input_->StopStreams();
                 input_->SetCallback(nullptr);
+            }
+
+            // Give the retained frames back to the driver. While the render
+            // thread is uploading a frame, it's deferred to the destructor;
+            // The upload holds a reference to this object, so it's never
+            // waited for here.
+            auto uploading = frameQueue_.IsPinned();
+            if (!uploading) ReleaseFrameBuffers();
+
+            if (input_ != nullptr)
+            {
+                if (settings_.audioChannelCount > 0) input_->DisableAudioInput();
                 input_->DisableVideoInput();
+                input_->SetVideoInputFrameMemoryAllocator(nullptr);
             }
 
             // Release the internal objects.
@@ -159,6 +527,12 @@ namespace klinker
                 input_->Release();
                 input_ = nullptr;
             }
+
+            if (allocator_ != nullptr && !uploading)
+            {
+                allocator_->Release();
+                allocator_ = nullptr;
+            }
         }
 
         #pragma endregion
@@ -206,22 +580,22 @@ namespace klinker
         ) override
         {
             {
-                std::lock_guard<std::mutex> lock(mutex_);
+                auto lock = stats_.Lock(mutex_);
 
                 // Update the display mode information.
                 displayMode_->Release();
                 displayMode_ = mode;
                 mode->AddRef();
-
-                // Flush the frame queue.
-                while (!frameQueue_.empty()) frameQueue_.pop();
             }
 
+            // Flush the frame queue and resize the frame pool.
+            ResetFrameBuffers(CalculateFrameDataSize());
+
             // Change the video input format as notified.
             input_->PauseStreams();
             input_->EnableVideoInput(
                 displayMode_->GetDisplayMode(),
-                bmdFormat8BitYUV,
+                GetPixelFormat(),
                 bmdVideoInputEnableFormatDetection
             );
             input_->FlushStreams();
@@ -235,29 +609,114 @@ namespace klinker
             IDeckLinkAudioInputPacket* audioPacket
         ) override
         {
+            StatisticsRecorder::CallbackScope callbackScope(stats_);
+
+            // Audio packets can arrive without video frames.
+            if (audioPacket != nullptr) CaptureAudio(audioPacket);
+
             if (videoFrame == nullptr) return S_OK;
 
-            if (frameQueue_.size() >= maxQueueLength_)
-            {
-                DebugLog("Overqueuing: Arrived frame was dropped.");
-                dropCount_++;
-                return S_OK;
-            }
+            // Give back the frames retired on this side.
+            ReleaseRetiredFrames(producerRetired_);
+
+            // Host arrival time and hardware reference timestamp
+            auto arrivalTime = LatencyHistogram::GetHostTime();
+
+            BMDTimeValue hardwareTime, hardwareDuration;
+            if (videoFrame->GetHardwareReferenceTimestamp(
+                flicksPerSecond, &hardwareTime, &hardwareDuration) != S_OK)
+                hardwareTime = AudioRing::noTime;
 
             // Calculate the data size.
-            auto size = videoFrame->GetRowBytes() * videoFrame->GetHeight();
-            assert(size == CalculateFrameDataSize());
+            auto width = videoFrame->GetWidth();
+            auto height = videoFrame->GetHeight();
+            auto size = CalculateFrameDataSize(width, height);
 
             // Retrieve the data pointer.
             std::uint8_t* source;
             ShouldOK(videoFrame->GetBytes(reinterpret_cast<void**>(&source)));
 
-            // Retrieve the timecode.
+            // Retrieve the timecode and the stream time.
             auto timecode = GetFrameTimecode(videoFrame);
 
-            // Allocate and push a new frame to the frame queue.
-            std::lock_guard<std::mutex> lock(mutex_);
-            frameQueue_.emplace(timecode, source, size);
+            BMDTimeValue streamTime, frameDuration;
+            if (videoFrame->GetStreamTime(&streamTime, &frameDuration, flicksPerSecond) != S_OK)
+                streamTime = AudioRing::noTime;
+
+            // Resize the frame pool if the frame size was changed.
+            if (size != framePool_.GetBufferSize()) ResetFrameBuffers(size);
+
+            // Make room following the overflow policy. It fails only with
+            // DropNewest.
+            if (!MakeRoomForFrame())
+            {
+                DebugLog("Overqueuing: Arrived frame was dropped.");
+                stats_.Update([](StatisticsRecorder::Counters& c) { c.framesIn++; c.dropsNewest++; });
+                return S_OK;
+            }
+
+            // Take a slot from the frame queue. It fails when the slot is
+            // still pinned by a reader, regardless of the policy.
+            auto slot = frameQueue_.BeginPush();
+
+            if (slot == nullptr)
+            {
+                DebugLog("Arrived frame was dropped: The slot is in use.");
+                stats_.Update([](StatisticsRecorder::Counters& c) { c.framesIn++; c.dropsPinned++; });
+                return S_OK;
+            }
+
+            auto copyStart = StatisticsRecorder::GetTime();
+            std::int64_t copyBytes = 0;
+
+            if (settings_.captureFormat == CaptureFormat::YUV10)
+            {
+                copyBytes = size;
+
+                // 10-bit mode: Unpack the v210 data into the slot buffer
+                // (half-precision UYVY). No zero-copy in this case.
+                V210Unpacker::UnpackFrame(
+                    source, videoFrame->GetRowBytes(),
+                    slot->buffer_, width, height
+                );
+                slot->image_ = slot->buffer_;
+            }
+            else if (retainedCount_ < settings_.maxRetainedFrames)
+            {
+                // Zero-copy mode: Retain the frame and push it as it is.
+                // The number of retained frames is limited not to exhaust
+                // the driver's buffer pool; It falls back to copying at the limit.
+                videoFrame->AddRef();
+                retainedCount_++;
+                slot->retained_ = videoFrame;
+                slot->image_ = source;
+            }
+            else
+            {
+                // Copy mode: Copy the frame data into the slot buffer.
+                std::memcpy(slot->buffer_, source, size);
+                copyBytes = size;
+                slot->image_ = slot->buffer_;
+            }
+
+            slot->timecode_ = timecode;
+            slot->streamTime_ = streamTime;
+            slot->hardwareTime_ = hardwareTime;
+            slot->arrivalTime_ = arrivalTime;
+            slot->width_ = static_cast<int>(width);
+            slot->height_ = static_cast<int>(height);
+
+            auto copyTime = StatisticsRecorder::GetTime() - copyStart;
+
+            // Publish the slot.
+            frameQueue_.EndPush();
+
+            std::int64_t depth = frameQueue_.CountQueued();
+            stats_.Update([=](StatisticsRecorder::Counters& c) {
+                c.framesIn++;
+                c.AddCopy(copyBytes, copyTime);
+                c.SampleQueueDepth(depth);
+            });
 
             return S_OK;
         }
@@ -270,10 +729,20 @@ namespace klinker
 
         struct FrameData
         {
-            std::uint32_t timecode_;
-            std::vector<uint8_t> image_;
-            FrameData(std::uint32_t timecode, std::uint8_t* source, std::size_t size)
-                : timecode_(timecode), image_(source, source + size) {}
+            std::uint32_t timecode_ = 0;
+            std::int64_t streamTime_ = 0;   // Stream time (flicks)
+            std::int64_t hardwareTime_ = 0; // Hardware reference time (flicks)
+            std::int64_t arrivalTime_ = 0;  // Host arrival time (us)
+            int width_ = 0, height_ = 0;
+
+            // Pointer to the image (buffer_ or the retained frame data)
+            std::uint8_t* image_ = nullptr;
+
+            // Frame pool buffer bound to this slot
+            std::uint8_t* buffer_ = nullptr;
+
+            // Input frame object retained in the zero-copy mode
+            IDeckLinkVideoInputFrame* retained_ = nullptr;
         };
 
         #pragma endregion
@@ -282,15 +751,220 @@ namespace klinker
 
         std::atomic<ULONG> refCount_ = 1;
         std::string error_;
+        std::uint32_t handle_ = 0;
+        ReceiverSettings settings_;
 
         IDeckLinkInput* input_ = nullptr;
         IDeckLinkDisplayMode* displayMode_ = nullptr;
+        // Optional allocator that lets the driver capture frames directly
+        // into page-aligned memory owned by the plugin (useful in
+        // combination with the zero-copy mode)
+        FrameAllocator* allocator_ = nullptr;
+
+        // Preallocated frame buffers bound to the queue slots, so no heap
+        // allocation happens on the callback thread in steady state
+        FramePool framePool_;
+
+        // Lock-free SPSC ring: The callback thread is never blocked by the
+        // texture upload on the render thread.
+        FrameQueue<FrameData> frameQueue_;
+        mutable std::mutex mutex_; // Display mode lock
+
+        static const int defaultQueueDepth_ = 8;
+        static const int defaultPrerollLength_ = 3;
+
+        // Frame selection state (see SelectFrameForTime)
+        struct SelectionState
+        {
+            std::int64_t lastTime = 0;
+            std::int64_t frameTime = 0;
+            bool started = false;
+            bool prerolled = false;
+        };
+
+        SelectionState selection_;
+
+        // Frame queue reader IDs
+        static const int uploadReader_ = 0;
+        static const int converterReader_ = 1;
+        static const int dequeueReader_ = 2;
+
+        // Frame latency histograms: host arrival to dequeue and to texture
+        // upload
+        LatencyHistogram dequeueLatency_;
+        LatencyHistogram uploadLatency_;
+
+        // Zero-copy mode: The number of the retained frames and the ones
+        // popped from the queue but still pinned by the readers. Retained
+        // frames are given back to the driver once they're popped and no
+        // reader pins them anymore. The lists are only accessed from the
+        // consumer/producer side respectively.
+        struct RetiredFrame
+        {
+            std::size_t index;
+            IDeckLinkVideoInputFrame* frame;
+        };
+
+        std::atomic<int> retainedCount_ = 0;
+        std::vector<RetiredFrame> consumerRetired_;
+        std::vector<RetiredFrame> producerRetired_;
+
+        // Frame, drop, queue depth and copy/callback/lock timing counters,
+        // read as a consistent snapshot from any thread
+        StatisticsRecorder stats_;
+
+        // Audio capture (48kHz, about one second of buffering). Packets
+        // carry the stream time, so they can be paired with the frames on
+        // the application side.
+        static const int audioSampleRate_ = 48000;
+        static const std::size_t audioRingLength_ = 48000;
+        AudioRing audioRing_;
+
+        void CaptureAudio(IDeckLinkAudioInputPacket* packet)
+        {
+            if (audioRing_.GetChannelCount() == 0) return;
+
+            void* samples;
+            if (packet->GetBytes(&samples) != S_OK) return;
+
+            BMDTimeValue time;
+            if (packet->GetPacketTime(&time, flicksPerSecond) != S_OK)
+                time = AudioRing::noTime;
+
+            auto count = static_cast<std::size_t>(packet->GetSampleFrameCount());
+
+            if (settings_.audioSampleDepth == 32)
+                audioRing_.Write(static_cast<const std::int32_t*>(samples), count, time);
+            else
+                audioRing_.Write(static_cast<const std::int16_t*>(samples), count, time);
+        }
+
+        // Discard queued frames following the overflow policy. Returns
+        // false if there is still no room for a new frame.
+        bool MakeRoomForFrame()
+        {
+            std::size_t depth = settings_.queueDepth;
+
+            switch (settings_.overflowPolicy)
+            {
+            case OverflowPolicy::DropOldest:
+            {
+                std::int64_t count = 0;
+                while (frameQueue_.CountQueued() >= depth)
+                    if (DropOldestFrame()) count++;
+                if (count > 0) stats_.Update([=](StatisticsRecorder::Counters& c) { c.dropsOldest += count; });
+                break;
+            }
+
+            case OverflowPolicy::Mailbox:
+            {
+                std::int64_t count = 0;
+                while (frameQueue_.CountQueued() > 0)
+                    if (DropOldestFrame()) count++;
+                if (count > 0) stats_.Update([=](StatisticsRecorder::Counters& c) { c.dropsSuperseded += count; });
+                break;
+            }
 
-        std::queue<FrameData> frameQueue_;
-        mutable std::mutex mutex_;
+            default:
+                break;
+            }
+
+            return frameQueue_.CountQueued() < depth;
+        }
+
+        BMDPixelFormat GetPixelFormat() const
+        {
+            return settings_.captureFormat == CaptureFormat::YUV10 ?
+                bmdFormat10BitYUV : bmdFormat8BitYUV;
+        }
+
+        // Copy the metadata of the oldest frame under the dequeue pin (the
+        // main thread). Returns false when the queue is empty.
+        bool CopyOldestFrame(FrameData& copy)
+        {
+            auto frame = frameQueue_.Pin(dequeueReader_);
+            if (frame != nullptr) copy = *frame;
+            frameQueue_.Unpin(dequeueReader_);
+            return frame != nullptr;
+        }
+
+        // Pop the oldest frame on the producer side.
+        bool DropOldestFrame()
+        {
+            std::size_t index;
+            if (!frameQueue_.Pop(&index)) return false;
+            RetireFrame(index, producerRetired_);
+            return true;
+        }
+
+        void ReleaseRetainedFrame(FrameData& frame)
+        {
+            if (frame.retained_ == nullptr) return;
+            frame.retained_->Release();
+            frame.retained_ = nullptr;
+            retainedCount_--;
+        }
+
+        // Move the retained frame out of a popped slot. It's given back to
+        // the driver right away, or later if a reader still pins the slot.
+        // The caller should own the slot (see FrameQueue::PopPinned).
+        void RetireFrame(std::size_t index, std::vector<RetiredFrame>& retired)
+        {
+            auto& slot = frameQueue_.GetSlot(index);
+            if (slot.retained_ == nullptr) return;
+            retired.push_back({ index, slot.retained_ });
+            slot.retained_ = nullptr;
+            ReleaseRetiredFrames(retired);
+        }
+
+        void ReleaseRetiredFrames(std::vector<RetiredFrame>& retired)
+        {
+            for (auto it = retired.begin(); it != retired.end();)
+            {
+                if (frameQueue_.IsPinned(it->index))
+                {
+                    ++it;
+                    continue;
+                }
+
+                it->frame->Release();
+                retainedCount_--;
+                it = retired.erase(it);
+            }
+        }
+
+        // Give the retained frames back and free the frame buffers.
+        void ReleaseFrameBuffers()
+        {
+            if (frameQueue_.GetCapacity() == 0) return;
+            ResetFrameBuffers(0);
+            ReleaseRetiredFrames(consumerRetired_);
+        }
+
+        // Flush the frame queue and rebind the slots to the frame pool
+        // buffers resized to a given size. This should be called from the
+        // callback thread or while the input stream is stopped.
+        void ResetFrameBuffers(std::size_t size)
+        {
+            frameQueue_.Flush();
+
+            // The readers may still be reading pinned slots. It's only for
+            // the upload/conversion period, so we simply wait for them.
+            while (frameQueue_.IsPinned()) std::this_thread::yield();
+
+            ReleaseRetiredFrames(producerRetired_);
+
+            auto count = frameQueue_.GetCapacity();
+            framePool_.Resize(size > 0 ? count : 0, size);
 
-        static const std::size_t maxQueueLength_ = 8;
-        int dropCount_ = 0;
+            for (std::size_t i = 0; i < count; i++)
+            {
+                auto& slot = frameQueue_.GetSlot(i);
+                ReleaseRetainedFrame(slot);
+                slot.buffer_ = size > 0 ? framePool_.GetBuffer(i) : nullptr;
+                slot.image_ = nullptr;
+            }
+        }
 
         static std::uint32_t GetFrameTimecode(IDeckLinkVideoInputFrame* frame)
         {
@@ -313,45 +987,21 @@ namespace klinker
             return bcdTime;
         }
 
-        bool InitializeInput(int deviceIndex, int formatIndex)
+        bool InitializeInput(const DeviceSelection& selection)
         {
-            // Device iterator
-            IDeckLinkIterator* iterator;
-            auto res = CoCreateInstance(
-                CLSID_CDeckLinkIterator, nullptr, CLSCTX_ALL,
-                IID_IDeckLinkIterator, reinterpret_cast<void**>(&iterator)
-            );
-
-            if (res != S_OK)
+            if (selection.device == nullptr)
             {
-                error_ = "DeckLink driver is not found.";
+                error_ = selection.error;
                 return false;
             }
 
-            // Iterate until reaching the specified index.
-            IDeckLink* device = nullptr;
-            for (auto i = 0; i <= deviceIndex; i++)
-            {
-                if (device != nullptr) device->Release();
-                res = iterator->Next(&device);
-
-                if (res != S_OK)
-                {
-                    error_ = "Invalid device index.";
-                    iterator->Release();
-                    return false;
-                }
-            }
-
-            iterator->Release(); // The iterator is no longer needed.
-
-            // Input interface of the specified device
-            res = device->QueryInterface(
+            // Input interface of the selected device
+            auto res = selection.device->QueryInterface(
                 IID_IDeckLinkInput,
                 reinterpret_cast<void**>(&input_)
             );
 
-            device->Release(); // The device object is no longer needed.
+            selection.device->Release(); // The device object is no longer needed.
 
             if (res != S_OK)
             {
@@ -359,37 +1009,40 @@ namespace klinker
                 return false;
             }
 
-            // Display mode iterator
-            IDeckLinkDisplayModeIterator* dmIterator;
-            res = input_->GetDisplayModeIterator(&dmIterator);
+            // Display mode object of the selected mode
+            BMDDisplayModeSupport support;
+            res = input_->DoesSupportVideoMode(
+                selection.mode, GetPixelFormat(), bmdVideoInputFlagDefault,
+                &support, &displayMode_
+            );
 
+            if (res != S_OK || displayMode_ == nullptr)
+            {
+                error_ = "Unsupported display mode or pixel format.";
+                return false;
+            }
+
+            // Set this object as a frame input callback.
+            res = input_->SetCallback(this);
             assert(res == S_OK);
 
-            // Iterate until reaching the specified index.
-            for (auto i = 0; i <= formatIndex; i++)
+            // Install the frame memory allocator.
+            if (settings_.useFrameAllocator)
             {
-                if (displayMode_ != nullptr) displayMode_->Release();
-                res = dmIterator->Next(&displayMode_);
+                allocator_ = new FrameAllocator(settings_.useLargePages != 0);
+                res = input_->SetVideoInputFrameMemoryAllocator(allocator_);
 
                 if (res != S_OK)
                 {
-                    error_ = "Invalid format index.";
-                    device->Release();
-                    dmIterator->Release();
+                    error_ = "Can't install the frame memory allocator.";
                     return false;
                 }
             }
 
-            dmIterator->Release(); // The iterator is no longer needed.
-
-            // Set this object as a frame input callback.
-            res = input_->SetCallback(this);
-            assert(res == S_OK);
-
             // Enable the video input.
             res = input_->EnableVideoInput(
                 displayMode_->GetDisplayMode(),
-                bmdFormat8BitYUV,
+                GetPixelFormat(),
                 bmdVideoInputEnableFormatDetection
             );
 
@@ -399,6 +1052,24 @@ namespace klinker
                 return false;
             }
 
+            // Enable the audio input.
+            if (settings_.audioChannelCount > 0)
+            {
+                res = input_->EnableAudioInput(
+                    bmdAudioSampleRate48kHz,
+                    settings_.audioSampleDepth == 32 ?
+                        bmdAudioSampleType32bitInteger :
+                        bmdAudioSampleType16bitInteger,
+                    settings_.audioChannelCount
+                );
+
+                if (res != S_OK)
+                {
+                    error_ = "Can't enable audio input.";
+                    return false;
+                }
+            }
+
             return true;
         }
 
@@ -1,14 +1,137 @@
 #pragma once
 
 #include "Common.h"
+#include "AudioRing.h"
+#include "DeviceCatalog.h"
+#include "FramePacker.h"
+#include "OutputFramePool.h"
+#include "Statistics.h"
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <cstring>
+#include <deque>
 #include <mutex>
+#include <thread>
 #include <tuple>
+#include <vector>
 
 namespace klinker
 {
+    //
+    // Sender input/output formats
+    //
+    // UYVY input is passed through to UYVY output (the subsampler shader
+    // does the conversion on GPU). RGBA input is packed into the output
+    // format on CPU by the frame packer.
+    //
+    enum class SenderInputFormat : int { UYVY, RGBA8, RGBAHalf };
+    enum class SenderOutputFormat : int { UYVY, V210, BGRA8 };
+
+    //
+    // Late frame recovery policy
+    //
+    // When a frame is going to be scheduled in the past (the host has
+    // stalled), the schedule skips ahead to the target latency.
+    //
+    // Repeat: The frame is scheduled at the new position. The output holds
+    //         the previous picture over the skipped period.
+    // Drop:   The frame is discarded, and the next one goes to the new
+    //         position. Manual mode only; The async mode treats it as
+    //         Repeat (see LateFrameRecovery).
+    // None:   No recovery (the legacy behavior).
+    //
+    enum class LateFramePolicy : int { Repeat, Drop, None };
+
+    //
+    // Late frame recovery
+    //
+    // The schedule arithmetic of the recovery. It doesn't touch the device,
+    // so it can be tested in isolation (see Tests/SenderRecoveryTest.cpp).
+    //
+    struct LateFrameRecovery
+    {
+        // New schedule position (in frames) for a frame that is going to
+        // be displayed after the playhead, or -1 if it's on time.
+        static std::int64_t SkipAhead(
+            std::int64_t queued, std::int64_t frameDuration,
+            std::int64_t playhead, int lead
+        )
+        {
+            if (frameDuration * queued >= playhead) return -1;
+            return playhead / frameDuration + lead;
+        }
+
+        // The async mode reschedules one frame per completion, so the
+        // number of frames in flight is fixed. A dropped frame would never
+        // be replaced, and the output stalls once they run out.
+        static bool ShouldDrop(LateFramePolicy policy, bool asyncMode)
+        {
+            return policy == LateFramePolicy::Drop && !asyncMode;
+        }
+    };
+
+    //
+    // Sender settings
+    //
+    // Plain data structure passed from the managed side. The layout should
+    // be kept in sync with SenderPlugin.Settings.
+    //
+    struct SenderSettings
+    {
+        SenderInputFormat inputFormat = SenderInputFormat::UYVY;
+        SenderOutputFormat outputFormat = SenderOutputFormat::UYVY;
+        int linearInput = 0; // RGBAHalf: Linear color space input
+
+        // Number of the embedded audio channels (2, 8 or 16).
+        // Zero disables the audio output.
+        int audioChannelCount = 0;
+
+        // Audio sample depth: 32 selects 32-bit, otherwise 16-bit.
+        int audioSampleDepth = 16;
+
+        // Adaptive preroll bounds (async mode). The preroll depth is
+        // adjusted between them. Zero maxPreroll disables it.
+        int minPreroll = 0;
+        int maxPreroll = 0;
+
+        // Late frame recovery policy and the target latency in frames
+        // after recovery (zero: the preroll depth)
+        LateFramePolicy latePolicy = LateFramePolicy::Repeat;
+        int recoveryLead = 0;
+
+        // Don't start the playback on creation. It's started with
+        // StartPlayback (e.g. by SenderGroup) after prerolling.
+        int deferredStart = 0;
+
+        // Run FeedFrame (copy/packing and scheduling) on a worker thread.
+        int workerThread = 0;
+
+        // Length of the output queue kept by the application in the manual
+        // mode, used to size the frame pool. Zero or less selects the
+        // default.
+        int queueLength = 0;
+    };
+
+    //
+    // Audio output statistics
+    //
+    // Plain data structure passed to the managed side. The layout should be
+    // kept in sync with SenderPlugin.AudioStats.
+    //
+    struct AudioOutputStats
+    {
+        std::int64_t scheduledFrames; // Sample frames given to the driver
+        std::int64_t overruns;        // Pushes discarded (ring full)
+        std::int64_t resyncs;         // Times the audio fell behind playback
+        std::int32_t queuedFrames;    // Sample frames waiting in the ring
+        std::int32_t bufferedFrames;  // Sample frames buffered in the driver
+    };
+
+    // Completion fence callback (called on the completion callback thread)
+    using CompletionCallback = void (*)(void* userData, std::int64_t completedCount);
+
     //
     // Frame sender class
     //
@@ -31,18 +154,34 @@ namespace klinker
     //
     // The length of the output queue is controlled by Unity.
     //
-    class Sender final : private IDeckLinkVideoOutputCallback
+    // In both modes, output frames are recycled through a preallocated
+    // frame pool, and embedded audio is scheduled along with them.
+    //
+    class Sender final :
+        private IDeckLinkVideoOutputCallback,
+        private IDeckLinkAudioOutputCallback
     {
     public:
 
         #pragma region Constructor/destructor
 
+        Sender(const SenderSettings& settings = SenderSettings())
+          : settings_(settings)
+        {
+            if (settings_.queueLength <= 0) settings_.queueLength = defaultQueueLength_;
+            fenceEvent_ = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        }
+
         ~Sender()
         {
             // Internal objects should have been released.
             assert(output_ == nullptr);
             assert(displayMode_ == nullptr);
             assert(frame_ == nullptr);
+            assert(pending_ == nullptr);
+            assert(!worker_.joinable());
+
+            if (fenceEvent_ != nullptr) CloseHandle(fenceEvent_);
         }
 
         #pragma endregion
@@ -76,7 +215,77 @@ namespace klinker
 
         int CountDroppedFrames() const
         {
-            return dropCount_;
+            return static_cast<int>(stats_.GetCounters().lateFrames);
+        }
+
+        // Consistent snapshot of the statistics (any thread)
+        Statistics GetStatistics() const
+        {
+            return stats_.GetSnapshot();
+        }
+
+        // Row bytes of the output frame buffer
+        std::size_t GetFrameRowBytes() const
+        {
+            assert(displayMode_ != nullptr);
+            auto width = displayMode_->GetWidth();
+            switch (settings_.outputFormat)
+            {
+                case SenderOutputFormat::V210: return FramePacker::GetV210RowBytes(width);
+                case SenderOutputFormat::BGRA8: return FramePacker::GetBGRARowBytes(width);
+                default: return FramePacker::GetUYVYRowBytes(width);
+            }
+        }
+
+        // Row bytes of the frame data given to FeedFrame
+        std::size_t GetInputRowBytes() const
+        {
+            assert(displayMode_ != nullptr);
+            if (settings_.inputFormat == SenderInputFormat::UYVY)
+                return FramePacker::GetUYVYRowBytes(displayMode_->GetWidth());
+            else
+                return packer_.GetInputRowBytes();
+        }
+
+        std::size_t GetFrameDataSize() const
+        {
+            assert(displayMode_ != nullptr);
+            return GetFrameRowBytes() * displayMode_->GetHeight();
+        }
+
+        // Current target depth of the output queue (async mode)
+        int GetPrerollDepth() const
+        {
+            return prerollDepth_;
+        }
+
+        int CountBufferedFrames() const
+        {
+            assert(output_ != nullptr);
+            unsigned int count = 0;
+            ShouldOK(output_->GetBufferedVideoFrameCount(&count));
+            return static_cast<int>(count);
+        }
+
+        FramePoolStats GetFramePoolStats() const
+        {
+            return framePool_.GetStats();
+        }
+
+        AudioOutputStats GetAudioStats() const
+        {
+            AudioOutputStats stats = {};
+            stats.scheduledFrames = audioScheduled_;
+            stats.overruns = audioRing_.CountOverruns();
+            stats.resyncs = audioResyncs_;
+            stats.queuedFrames = static_cast<std::int32_t>(audioRing_.CountReadable());
+
+            unsigned int buffered = 0;
+            if (output_ != nullptr && settings_.audioChannelCount > 0)
+                output_->GetBufferedAudioSampleFrameCount(&buffered);
+            stats.bufferedFrames = static_cast<std::int32_t>(buffered);
+
+            return stats;
         }
 
         const std::string& GetErrorString() const
@@ -89,48 +298,155 @@ namespace klinker
         #pragma region Public methods
 
         void StartAsyncMode(int deviceIndex, int formatIndex, int preroll)
+        {
+            StartAsyncMode(DeviceCatalog::GetInstance().SelectOutput(deviceIndex, formatIndex), preroll);
+        }
+
+        // The device reference in the selection is consumed.
+        void StartAsyncMode(const DeviceSelection& selection, int preroll)
         {
             assert(output_ == nullptr);
             assert(displayMode_ == nullptr);
             assert(frame_ == nullptr);
 
-            if (!InitializeOutput(deviceIndex, formatIndex)) return;
+            if (!InitializeOutput(selection)) return;
+            if (!InitializePacker()) return;
+
+            // Adaptive preroll: Clamp the initial depth to the bounds.
+            if (settings_.maxPreroll > 0)
+                preroll = std::min(std::max(preroll, std::max(settings_.minPreroll, 1)), settings_.maxPreroll);
+            prerollDepth_ = preroll;
+
+            if (!AllocateFramePool(std::max(preroll, settings_.maxPreroll) + poolHeadroom_)) return;
 
             // Prerolling
-            frame_ = AllocateFrame();
+            asyncMode_ = true;
+            frame_ = framePool_.Acquire();
             for (auto i = 0; i < preroll; i++) ScheduleFrame(frame_);
 
-            ShouldOK(output_->StartScheduledPlayback(0, 1, 1));
+            if (settings_.workerThread) StartWorker();
+            if (!settings_.deferredStart) StartPlayback();
         }
 
         void StartManualMode(int deviceIndex, int formatIndex)
+        {
+            StartManualMode(DeviceCatalog::GetInstance().SelectOutput(deviceIndex, formatIndex));
+        }
+
+        // The device reference in the selection is consumed.
+        void StartManualMode(const DeviceSelection& selection)
         {
             assert(output_ == nullptr);
             assert(displayMode_ == nullptr);
             assert(frame_ == nullptr);
 
-            if (!InitializeOutput(deviceIndex, formatIndex)) return;
+            if (!InitializeOutput(selection)) return;
+            if (!InitializePacker()) return;
+            if (!AllocateFramePool(settings_.queueLength + poolHeadroom_)) return;
+
+            if (settings_.workerThread) StartWorker();
+            if (!settings_.deferredStart) StartPlayback();
+        }
+
+        // Preroll the audio ahead of StartPlayback. It's optional (done in
+        // StartPlayback otherwise) but keeps StartPlayback short for a
+        // timed start.
+        void PreparePlayback()
+        {
+            if (output_ == nullptr || playing_ || prepared_) return;
+            if (settings_.audioChannelCount > 0) PrerollAudio();
+            prepared_ = true;
+        }
 
-            ShouldOK(output_->StartScheduledPlayback(0, 1, 1));
+        // Start the scheduled playback. Only needed with deferredStart.
+        // The playback starts on the next frame boundary from a given
+        // stream time (flicks).
+        bool StartPlayback(std::int64_t startTime = 0)
+        {
+            if (output_ == nullptr) return false;
+            if (playing_) return true;
+            PreparePlayback();
+            playing_ = output_->StartScheduledPlayback(startTime, flicksPerSecond, 1) == S_OK;
+            assert(playing_);
+            return playing_;
+        }
+
+        bool IsPlaying() const
+        {
+            return playing_;
+        }
+
+        // Hardware reference clock in flicks. timeInFrame is the elapsed
+        // time in the current frame.
+        bool GetHardwareClock(std::int64_t& time, std::int64_t& timeInFrame, std::int64_t& frameDuration) const
+        {
+            if (output_ == nullptr) return false;
+            BMDTimeValue t, inFrame, perFrame;
+            auto res = output_->GetHardwareReferenceClock(flicksPerSecond, &t, &inFrame, &perFrame);
+            if (res != S_OK) return false;
+            time = t;
+            timeInFrame = inFrame;
+            frameDuration = perFrame;
+            return true;
+        }
+
+        // Stream time of the playhead in flicks. hostTime is the host
+        // clock (us) at the reading, which can be used to compare readings
+        // taken at different times.
+        bool GetPlaybackTime(std::int64_t& time, std::int64_t& hostTime) const
+        {
+            if (output_ == nullptr || !playing_) return false;
+            BMDTimeValue t;
+            double speed;
+            auto before = LatencyHistogram::GetHostTime();
+            if (output_->GetScheduledStreamTime(flicksPerSecond, &t, &speed) != S_OK) return false;
+            auto after = LatencyHistogram::GetHostTime();
+            time = t;
+            hostTime = (before + after) / 2;
+            return true;
         }
 
         void Stop()
         {
+            // Finish the queued feeds.
+            StopWorker();
+
             // Stop the output stream.
             if (output_ != nullptr)
             {
                 output_->StopScheduledPlayback(0, nullptr, 1);
                 output_->SetScheduledFrameCompletionCallback(nullptr);
                 output_->DisableVideoOutput();
+
+                if (settings_.audioChannelCount > 0)
+                {
+                    output_->SetAudioCallback(nullptr);
+                    output_->DisableAudioOutput();
+                }
             }
 
             // Release the internal objects.
             if (frame_ != nullptr)
             {
-                frame_->Release();
+                framePool_.Release(frame_);
                 frame_ = nullptr;
             }
 
+            if (auto latest = latest_.exchange(nullptr))
+                framePool_.Release(latest);
+
+            asyncMode_ = false;
+            playing_ = false;
+            prepared_ = false;
+
+            if (pending_ != nullptr)
+            {
+                framePool_.Release(pending_);
+                pending_ = nullptr;
+            }
+
+            framePool_.Reset();
+
             if (displayMode_ != nullptr)
             {
                 displayMode_->Release();
@@ -144,29 +460,85 @@ namespace klinker
             }
         }
 
-        void FeedFrame(void* frameData, unsigned int timecode)
+        // Feed a frame in the input format. Returns a feed ticket: The
+        // source buffer can be reused when GetCompletedFeedCount reaches it.
+        // It's immediately completed without the worker thread. With the
+        // worker thread, it blocks only when the feed queue is full.
+        std::int64_t FeedFrame(const void* frameData, unsigned int timecode)
+        {
+            if (!worker_.joinable())
+            {
+                CopyFrame(frameData, timecode);
+                return ++feeds_.queued;
+            }
+
+            auto lock = stats_.Lock(feedMutex_);
+            feedCondition_.wait(lock, [=]() { return feedQueue_.size() < maxQueuedFeeds_; });
+            feedQueue_.push_back({ frameData, timecode });
+            feedCondition_.notify_all();
+            return ++feeds_.queued;
+        }
+
+        std::int64_t GetCompletedFeedCount() const
+        {
+            return worker_.joinable() ? feeds_.completed.load() : feeds_.queued.load();
+        }
+
+        // Wait until the feed with a given ticket is completed.
+        void WaitFeedCompletion(std::int64_t ticket)
+        {
+            if (!worker_.joinable()) return;
+            std::unique_lock<std::mutex> lock(feedMutex_);
+            feedCondition_.wait(lock, [=]() { return feeds_.completed >= ticket; });
+        }
+
+        // Direct-write API: Acquire a pooled frame and return its buffer.
+        // The producer can write the frame data into it in place, then call
+        // CommitFrame to schedule it. It returns the same buffer until
+        // committed.
+        void* AcquireFrameBuffer()
         {
             assert(output_ != nullptr);
             assert(displayMode_ != nullptr);
             assert(error_.empty());
 
-            // Allocate a new frame for the fed data.
-            auto newFrame = AllocateFrame();
-            CopyFrameData(newFrame, frameData);
+            if (pending_ == nullptr)
+            {
+                pending_ = framePool_.Acquire();
+                if (pending_ == nullptr) return nullptr;
+            }
+
+            void* pointer = nullptr;
+            ShouldOK(pending_->GetBytes(&pointer));
+            return pointer;
+        }
+
+        void CommitFrame(unsigned int timecode)
+        {
+            if (pending_ == nullptr) return;
+
+            auto newFrame = pending_;
+            pending_ = nullptr;
+
             SetTimecode(newFrame, timecode);
 
-            if (IsAsyncMode())
+            stats_.Update([](StatisticsRecorder::Counters& c) { c.framesIn++; });
+
+            if (asyncMode_)
             {
-                // Async mode: Replace the frame_ object with it.
-                std::lock_guard<std::mutex> lock(mutex_);
-                frame_->Release();
-                frame_ = newFrame;
+                // Async mode: Publish it as the latest frame. The previous
+                // one is discarded if the callback hasn't taken it yet.
+                if (auto stale = latest_.exchange(newFrame))
+                {
+                    framePool_.Release(stale);
+                    stats_.Update([](StatisticsRecorder::Counters& c) { c.dropsSuperseded++; });
+                }
             }
             else
             {
                 // Manual mode: Immediately schedule it.
                 ScheduleFrame(newFrame);
-                newFrame->Release();
+                framePool_.Release(newFrame);
 
                 // Note: We don't have to use the mutex because nothing here
                 // conflicts with the completion callback.
@@ -180,16 +552,91 @@ namespace klinker
             }
         }
 
-        void WaitFrameCompletion(std::int64_t frameNumber)
+        // Push interleaved audio samples into the audio ring. Returns false
+        // when there is no room for them. This doesn't allocate memory, so
+        // it can be called from an audio callback.
+        bool PushAudio(const float* samples, std::size_t frameCount)
         {
-            // Wait for completion of a specified frame.
+            return audioRing_.Write(samples, frameCount);
+        }
+
+        // Wait for completion of a specified frame. Returns false on
+        // timeout. A timeout is not treated as an error; It's only counted.
+        // It spins briefly before blocking to wake up with sub-millisecond
+        // latency.
+        bool WaitFrameCompletion(std::int64_t frameNumber, int timeoutMilliseconds = defaultTimeout_)
+        {
+            using namespace std::chrono;
+
+            if (counters_.completed >= frameNumber) return true;
+
+            // Spin phase
+            auto spinEnd = steady_clock::now() + microseconds(spinMicroseconds_);
+            while (steady_clock::now() < spinEnd)
+            {
+                if (counters_.completed >= frameNumber) return true;
+                std::this_thread::yield();
+            }
+
+            // Blocking phase
             std::unique_lock<std::mutex> lock(mutex_);
+            waiters_++;
             auto res = condition_.wait_for(
-                lock, std::chrono::milliseconds(200),
+                lock, milliseconds(timeoutMilliseconds),
                 [=]() { return counters_.completed >= frameNumber; }
             );
+            waiters_--;
+
+            if (!res)
+            {
+                DebugLog("Frame completion wait timed out.");
+                waitTimeouts_++;
+            }
+
+            return res;
+        }
+
+        // Lock-free; It can be polled instead of waiting.
+        std::int64_t GetCompletedFrameCount() const
+        {
+            return counters_.completed;
+        }
+
+        // Number of the late frame recoveries (schedule skip-aheads)
+        std::int64_t CountRecoveries() const
+        {
+            return recoveries_;
+        }
+
+        std::int64_t CountWaitTimeouts() const
+        {
+            return waitTimeouts_;
+        }
+
+        // Arm the completion fence. The fence event (auto-reset Win32 event)
+        // is signaled and the callback is called once the specified frame
+        // is completed. If it has been already completed, only the event is
+        // signaled here; The callback is never called on this thread.
+        void SetCompletionFence(std::int64_t frameNumber)
+        {
+            fence_ = frameNumber;
+            if (DisarmFence(counters_.completed)) SetEvent(fenceEvent_);
+        }
 
-            if (!res) error_ = "Failed to synchronize to output refreshing.";
+        // The callback is called on the completion callback thread, so it
+        // shouldn't block. It's called without holding the lock, so a call
+        // in progress can still use the old callback after replacing it.
+        void SetCompletionCallback(CompletionCallback callback, void* userData)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            callbackUserData_ = userData;
+            callback_ = callback;
+        }
+
+        // Auto-reset event signaled on reaching the fence
+        HANDLE GetCompletionEvent() const
+        {
+            return fenceEvent_;
         }
 
         #pragma endregion
@@ -200,7 +647,7 @@ namespace klinker
         {
             if (iid == IID_IUnknown)
             {
-                *ppv = this;
+                *ppv = (IDeckLinkVideoOutputCallback*)this;
                 AddRef();
                 return S_OK;
             }
@@ -212,6 +659,13 @@ namespace klinker
                 return S_OK;
             }
 
+            if (iid == IID_IDeckLinkAudioOutputCallback)
+            {
+                *ppv = (IDeckLinkAudioOutputCallback*)this;
+                AddRef();
+                return S_OK;
+            }
+
             *ppv = nullptr;
             return E_NOINTERFACE;
         }
@@ -237,10 +691,11 @@ namespace klinker
             BMDOutputFrameCompletionResult result
         ) override
         {
+            StatisticsRecorder::CallbackScope callbackScope(stats_);
+
             if (result == bmdOutputFrameDisplayedLate)
             {
                 DebugLog("Frame was displayed late.");
-                dropCount_++;
             }
 
             if (result == bmdOutputFrameDropped)
@@ -248,14 +703,46 @@ namespace klinker
                 DebugLog("Frame was dropped.");
             }
 
-            std::lock_guard<std::mutex> lock(mutex_);
+            std::int64_t depth = CountBufferedFrames();
+            stats_.Update([=](StatisticsRecorder::Counters& c) {
+                c.framesOut++;
+                if (result == bmdOutputFrameDisplayedLate) c.lateFrames++;
+                if (result == bmdOutputFrameDropped) c.dropsOutput++;
+                if (result == bmdOutputFrameFlushed) c.dropsFlushed++;
+                c.SampleQueueDepth(depth);
+            });
+
+            auto late = result == bmdOutputFrameDisplayedLate ||
+                        result == bmdOutputFrameDropped;
+
+            // Give the frame back to the pool.
+            framePool_.Release(completedFrame);
+
+            // Increment the frame count and notify the waiters. The lock is
+            // only taken when there is a blocking waiter.
+            auto completed = ++counters_.completed;
+
+            if (waiters_ > 0)
+            {
+                auto lock = stats_.Lock(mutex_);
+                condition_.notify_all();
+            }
 
-            // Increment the frame count and notify the main thread.
-            counters_.completed++;
-            condition_.notify_all();
+            SignalFence(completed);
 
-            // Async mode: Schedule the next frame.
-            if (IsAsyncMode()) ScheduleFrame(frame_);
+            // Async mode: Schedule the newest frame. The frame_ object is
+            // only touched by the callback thread while running.
+            if (asyncMode_)
+            {
+                if (auto latest = latest_.exchange(nullptr))
+                {
+                    framePool_.Release(frame_);
+                    frame_ = latest;
+                }
+
+                auto count = UpdatePreroll(late);
+                for (auto i = 0; i < count; i++) ScheduleFrame(frame_);
+            }
 
             return S_OK;
         }
@@ -267,6 +754,17 @@ namespace klinker
 
         #pragma endregion
 
+        #pragma region IDeckLinkAudioOutputCallback implementation
+
+        HRESULT STDMETHODCALLTYPE RenderAudioSamples(BOOL preroll) override
+        {
+            ScheduleAudio();
+            if (preroll) audioPrerolled_ = true;
+            return S_OK;
+        }
+
+        #pragma endregion
+
     private:
 
         #pragma region Private members
@@ -274,50 +772,251 @@ namespace klinker
         std::atomic<ULONG> refCount_ = 1;
         std::string error_;
 
+        SenderSettings settings_;
+        FramePacker packer_;
+
         IDeckLinkOutput* output_ = nullptr;
         IDeckLinkDisplayMode* displayMode_ = nullptr;
-        IDeckLinkMutableVideoFrame* frame_ = nullptr;
+        // Async mode handoff (triple buffering): The producer commits the
+        // acquired frame to the lock-free latest-value slot, and the
+        // completion callback takes it from there. Neither side blocks.
+        IDeckLinkMutableVideoFrame* frame_ = nullptr;   // Scheduled by callback
+        IDeckLinkMutableVideoFrame* pending_ = nullptr; // Acquired frame
+        std::atomic<IDeckLinkMutableVideoFrame*> latest_ = nullptr; // Handoff
+        bool asyncMode_ = false;
+        std::atomic<bool> playing_ = false;
+        bool prepared_ = false;
+        OutputFramePool framePool_;
+
+        // Frame pool size: the queue length (the preroll depth or the
+        // manual mode queue length) plus headroom for the frame being
+        // filled and the one being replaced
+        static const int poolHeadroom_ = 2;
+        static const int defaultQueueLength_ = 3;
+
+        // Adaptive preroll state (callback thread only, except the depth)
+        static const int prerollWindow_ = 120;
+        std::atomic<int> prerollDepth_ = 0;
+        int windowCompletions_ = 0;
+        int windowLateFrames_ = 0;
 
         BMDTimeValue frameDuration_ = 0;
         BMDTimeScale timeScale_ = 1;
-        int dropCount_ = 0;
+
+        // Frame, drop and timing counters (see GetStatistics)
+        StatisticsRecorder stats_;
 
         std::mutex mutex_;
         std::condition_variable condition_;
 
         struct
         {
-            std::int64_t queued = 0;
-            std::int64_t completed = 0;
+            std::atomic<std::int64_t> queued = 0; // Also read by the audio callback
+            std::atomic<std::int64_t> completed = 0;
         }
         counters_;
 
-        bool IsAsyncMode() const
+        // Completion wait/fence
+        static const int defaultTimeout_ = 200;
+        static const int spinMicroseconds_ = 500;
+        std::atomic<int> waiters_ = 0;
+        std::atomic<std::int64_t> waitTimeouts_ = 0;
+        std::atomic<std::int64_t> recoveries_ = 0; // See RecoverSchedule
+        std::atomic<std::int64_t> fence_ = INT64_MAX;
+        HANDLE fenceEvent_ = nullptr;
+        CompletionCallback callback_ = nullptr;
+        void* callbackUserData_ = nullptr;
+
+        // Audio output (48kHz, about one second of buffering)
+        static const int audioSampleRate_ = 48000;
+        static const std::size_t audioRingLength_ = 48000;
+        static const std::size_t audioChunkLength_ = 2048;
+        AudioRing audioRing_;
+
+        // Audio callback thread only
+        std::vector<std::int32_t> audioChunk_; // Samples being scheduled
+        std::size_t audioChunkRead_ = 0, audioChunkCount_ = 0;
+        BMDTimeValue audioTime_ = 0; // Stream time of the next sample
+
+        std::atomic<std::int64_t> audioScheduled_ = 0;
+        std::atomic<std::int64_t> audioResyncs_ = 0;
+
+        // Audio preroll (see PrerollAudio)
+        static const int audioPrerollTimeout_ = 100; // ms
+        std::atomic<bool> audioPrerolled_ = false;
+
+        void* GetAudioChunkPointer(std::size_t offset)
         {
-            // This is a little bit hackish, but we can determine the
-            // current mode by checking if we have a frame_ object.
-            return frame_ != nullptr;
+            offset *= settings_.audioChannelCount;
+            if (settings_.audioSampleDepth == 32)
+                return audioChunk_.data() + offset;
+            else
+                return reinterpret_cast<std::int16_t*>(audioChunk_.data()) + offset;
         }
 
-        IDeckLinkMutableVideoFrame* AllocateFrame()
+        std::size_t ReadAudioChunk(std::size_t frameCount)
         {
-            auto width = displayMode_->GetWidth();
-            auto height = displayMode_->GetHeight();
-            IDeckLinkMutableVideoFrame* frame = nullptr;
-            ShouldOK(output_->CreateVideoFrame(
-                width, height, width * 2,
-                bmdFormat8BitYUV, bmdFrameFlagDefault, &frame
-            ));
-            return frame;
+            auto count = std::min(frameCount, audioChunkLength_);
+            if (settings_.audioSampleDepth == 32)
+                return audioRing_.Read(audioChunk_.data(), count);
+            else
+                return audioRing_.Read(reinterpret_cast<std::int16_t*>(audioChunk_.data()), count);
+        }
+
+        // Audio preroll: The driver requests the samples from the audio
+        // callback thread, which schedules them up to the video preroll
+        // depth. Waits for the request before starting the playback, so
+        // the audio starts along with the first video frame. The wait is
+        // bounded; The audio just starts late when it times out.
+        void PrerollAudio()
+        {
+            using namespace std::chrono;
+
+            audioPrerolled_ = false;
+            if (output_->BeginAudioPreroll() != S_OK) return;
+
+            auto timeout = steady_clock::now() + milliseconds(audioPrerollTimeout_);
+            while (!audioPrerolled_ && steady_clock::now() < timeout)
+                std::this_thread::yield();
+
+            if (!audioPrerolled_) DebugLog("Audio preroll timed out.");
+
+            ShouldOK(output_->EndAudioPreroll());
+        }
+
+        // Schedule the samples in the audio ring (audio callback thread)
+        // The audio stream time shares the timeline with the video frames,
+        // so the audio lead follows the video preroll.
+        void ScheduleAudio()
+        {
+            // Samples are scheduled up to the end of the last scheduled
+            // video frame.
+            auto horizon = counters_.queued.load() * frameDuration_ * audioSampleRate_ / timeScale_;
+
+            // Resynchronize when the audio has fallen behind the playhead
+            // (keep one video frame ahead).
+            if (audioChunkRead_ < audioChunkCount_ || audioRing_.CountReadable() > 0)
+            {
+                BMDTimeValue playhead;
+                double speed;
+                auto lead = frameDuration_ * audioSampleRate_ / timeScale_;
+                if (output_->GetScheduledStreamTime(audioSampleRate_, &playhead, &speed) == S_OK &&
+                    audioTime_ < playhead + lead)
+                {
+                    audioTime_ = playhead + lead;
+                    audioResyncs_++;
+                }
+            }
+
+            while (audioTime_ < horizon)
+            {
+                // Refill the chunk.
+                if (audioChunkRead_ == audioChunkCount_)
+                {
+                    audioChunkRead_ = 0;
+                    audioChunkCount_ = ReadAudioChunk(static_cast<std::size_t>(horizon - audioTime_));
+                    if (audioChunkCount_ == 0) break;
+                }
+
+                // The driver might take only a part of the chunk.
+                unsigned int written = 0;
+                auto res = output_->ScheduleAudioSamples(
+                    GetAudioChunkPointer(audioChunkRead_),
+                    static_cast<unsigned int>(audioChunkCount_ - audioChunkRead_),
+                    audioTime_, audioSampleRate_, &written
+                );
+
+                if (res != S_OK || written == 0) break;
+
+                audioChunkRead_ += written;
+                audioTime_ += written;
+                audioScheduled_ += written;
+            }
         }
 
-        void CopyFrameData(IDeckLinkMutableVideoFrame* frame, const void* data) const
+        // Output pixel format selected with the settings. FeedFrame takes
+        // the input format, while the direct-write buffer is in this one.
+        BMDPixelFormat GetPixelFormat() const
+        {
+            switch (settings_.outputFormat)
+            {
+                case SenderOutputFormat::V210: return bmdFormat10BitYUV;
+                case SenderOutputFormat::BGRA8: return bmdFormat8BitBGRA;
+                default: return bmdFormat8BitYUV;
+            }
+        }
+
+        bool InitializePacker()
+        {
+            // UYVY input can only be passed through.
+            if (settings_.inputFormat == SenderInputFormat::UYVY &&
+                settings_.outputFormat != SenderOutputFormat::UYVY)
+            {
+                error_ = "Unsupported format combination.";
+                return false;
+            }
+
+            packer_.Reset(
+                displayMode_->GetWidth(),
+                settings_.inputFormat == SenderInputFormat::RGBAHalf,
+                settings_.linearInput != 0
+            );
+
+            return true;
+        }
+
+        bool AllocateFramePool(int count)
         {
             auto width = displayMode_->GetWidth();
             auto height = displayMode_->GetHeight();
-            void* pointer = nullptr;
-            ShouldOK(frame->GetBytes(&pointer));
-            std::memcpy(pointer, data, (std::size_t)2 * width * height);
+            auto rowBytes = static_cast<long>(GetFrameRowBytes());
+
+            if (!framePool_.Allocate(
+                output_, count, width, height, rowBytes, GetPixelFormat()
+            ))
+            {
+                error_ = "Can't allocate output frames.";
+                return false;
+            }
+
+            return true;
+        }
+
+        // Update the adaptive preroll state on a completion. Returns the
+        // number of frames to be scheduled (0: shrink, 1: keep, 2: grow).
+        // The depth grows by one on a late/dropped frame and shrinks by one
+        // after a clean window of completions, within the settings bounds.
+        int UpdatePreroll(bool late)
+        {
+            if (settings_.maxPreroll <= 0) return 1;
+
+            auto depth = prerollDepth_.load();
+
+            windowCompletions_++;
+            if (late) windowLateFrames_++;
+
+            if (late && depth < settings_.maxPreroll)
+            {
+                // Grow immediately on a late frame.
+                depth++;
+                windowCompletions_ = windowLateFrames_ = 0;
+            }
+            else if (windowCompletions_ >= prerollWindow_)
+            {
+                // Shrink after a clean window.
+                if (windowLateFrames_ == 0 && depth > std::max(settings_.minPreroll, 1)) depth--;
+                windowCompletions_ = windowLateFrames_ = 0;
+            }
+
+            prerollDepth_ = depth;
+
+            // Compare the depth with the actual queue length (the completed
+            // frame has been removed from it).
+            unsigned int buffered;
+            if (output_->GetBufferedVideoFrameCount(&buffered) != S_OK) return 1;
+
+            auto deficit = depth - static_cast<int>(buffered);
+            return std::min(std::max(deficit, buffered > 0 ? 0 : 1), 2);
         }
 
         void SetTimecode(IDeckLinkMutableVideoFrame* frame, unsigned int timecode) const
@@ -338,53 +1037,203 @@ namespace klinker
             );
         }
 
+        // Feed worker: FeedFrame only queues the source pointer, and the
+        // copy/packing, timecode stamping and scheduling are done on this
+        // thread. The direct-write API shouldn't be used with it.
+        struct FeedJob
+        {
+            const void* data;
+            unsigned int timecode;
+        };
+
+        static const std::size_t maxQueuedFeeds_ = 3;
+        std::thread worker_;
+        std::mutex feedMutex_;
+        std::condition_variable feedCondition_;
+        std::deque<FeedJob> feedQueue_;
+        bool stopWorker_ = false;
+
+        struct
+        {
+            std::atomic<std::int64_t> queued = 0;
+            std::atomic<std::int64_t> completed = 0;
+        }
+        feeds_;
+
+        void StartWorker()
+        {
+            stopWorker_ = false;
+            worker_ = std::thread([this]() { RunWorker(); });
+        }
+
+        void StopWorker()
+        {
+            if (!worker_.joinable()) return;
+
+            {
+                std::lock_guard<std::mutex> lock(feedMutex_);
+                stopWorker_ = true;
+                feedCondition_.notify_all();
+            }
+
+            worker_.join();
+        }
+
+        void RunWorker()
+        {
+            std::unique_lock<std::mutex> lock(feedMutex_);
+
+            while (true)
+            {
+                feedCondition_.wait(lock, [=]() { return !feedQueue_.empty() || stopWorker_; });
+
+                // The remaining jobs are processed before stopping.
+                if (feedQueue_.empty()) break;
+
+                auto job = feedQueue_.front();
+                lock.unlock();
+
+                CopyFrame(job.data, job.timecode);
+
+                lock.lock();
+                feedQueue_.pop_front();
+                feeds_.completed++;
+                feedCondition_.notify_all();
+            }
+        }
+
+        // Copy/pack a frame into an output frame and commit it.
+        void CopyFrame(const void* frameData, unsigned int timecode)
+        {
+            auto buffer = AcquireFrameBuffer();
+
+            if (buffer == nullptr)
+            {
+                // No free output frame: The fed frame is lost.
+                stats_.Update([](StatisticsRecorder::Counters& c) { c.dropsNewest++; });
+                return;
+            }
+
+            auto copyStart = StatisticsRecorder::GetTime();
+
+            auto height = displayMode_->GetHeight();
+            auto rowBytes = GetFrameRowBytes();
+
+            switch (settings_.outputFormat)
+            {
+                case SenderOutputFormat::V210:
+                    packer_.PackV210(frameData, GetInputRowBytes(), buffer, rowBytes, height);
+                    break;
+                case SenderOutputFormat::BGRA8:
+                    packer_.PackBGRA(frameData, GetInputRowBytes(), buffer, rowBytes, height);
+                    break;
+                default:
+                    if (settings_.inputFormat == SenderInputFormat::UYVY)
+                        std::memcpy(buffer, frameData, GetFrameDataSize());
+                    else
+                        packer_.PackUYVY(frameData, GetInputRowBytes(), buffer, rowBytes, height);
+                    break;
+            }
+
+            auto copyTime = StatisticsRecorder::GetTime() - copyStart;
+            std::int64_t copyBytes = GetFrameDataSize();
+            stats_.Update([=](StatisticsRecorder::Counters& c) { c.AddCopy(copyBytes, copyTime); });
+
+            CommitFrame(timecode);
+        }
+
+        // Skip the schedule ahead if it has fallen behind the playback, so
+        // late frames don't pile up after a host stall (see LateFramePolicy).
+        // Returns false when the frame should be dropped.
+        bool RecoverSchedule()
+        {
+            if (settings_.latePolicy == LateFramePolicy::None) return true;
+
+            // Not available until the playback starts.
+            BMDTimeValue playhead;
+            double speed;
+            auto res = output_->GetScheduledStreamTime(timeScale_, &playhead, &speed);
+            if (res != S_OK || speed == 0) return true;
+
+            auto lead = settings_.recoveryLead > 0 ?
+                settings_.recoveryLead : std::max(prerollDepth_.load(), 1);
+
+            // Is the frame going to be displayed late?
+            auto position = LateFrameRecovery::SkipAhead(
+                counters_.queued.load(), frameDuration_, playhead, lead
+            );
+            if (position < 0) return true;
+
+            counters_.queued = position;
+            recoveries_++;
+
+            DebugLog("Output schedule was behind the playback; Skipped ahead.");
+
+            if (!LateFrameRecovery::ShouldDrop(settings_.latePolicy, asyncMode_)) return true;
+
+            stats_.Update([](StatisticsRecorder::Counters& c) { c.dropsRecovery++; });
+            return false;
+        }
+
         void ScheduleFrame(IDeckLinkMutableVideoFrame* frame)
         {
+            if (!RecoverSchedule()) return;
+
+            // The frame is in use until its completion.
+            framePool_.Retain(frame);
+
             auto time = frameDuration_ * counters_.queued++;
-            ShouldOK(output_->ScheduleVideoFrame(
+            auto res = output_->ScheduleVideoFrame(
                 frame, time, frameDuration_, timeScale_
-            ));
+            );
+
+            assert(res == S_OK);
+            if (res != S_OK) framePool_.Release(frame);
         }
 
-        bool InitializeOutput(int deviceIndex, int formatIndex)
+        // Disarm the fence if it has been reached. Returns true only for
+        // the thread that disarmed it, so it's signaled only once.
+        bool DisarmFence(std::int64_t completed)
         {
-            // Device iterator
-            IDeckLinkIterator* iterator;
-            auto res = CoCreateInstance(
-                CLSID_CDeckLinkIterator, nullptr, CLSCTX_ALL,
-                IID_IDeckLinkIterator, reinterpret_cast<void**>(&iterator)
-            );
+            auto fence = fence_.load();
+            if (completed < fence) return false;
+            return fence_.compare_exchange_strong(fence, INT64_MAX);
+        }
 
-            if (res != S_OK)
+        // Signal the fence from the completion callback thread.
+        void SignalFence(std::int64_t completed)
+        {
+            if (!DisarmFence(completed)) return;
+
+            SetEvent(fenceEvent_);
+
+            // Copy the callback and call it outside the lock.
+            CompletionCallback callback;
+            void* userData;
             {
-                error_ = "DeckLink driver is not found.";
-                return false;
+                auto lock = stats_.Lock(mutex_);
+                callback = callback_;
+                userData = callbackUserData_;
             }
 
-            // Iterate until reaching the specified index.
-            IDeckLink* device = nullptr;
-            for (auto i = 0; i <= deviceIndex; i++)
-            {
-                if (device != nullptr) device->Release();
-                res = iterator->Next(&device);
+            if (callback != nullptr) callback(userData, completed);
+        }
 
-                if (res != S_OK)
-                {
-                    error_ = "Invalid device index.";
-                    iterator->Release();
-                    return false;
-                }
+        bool InitializeOutput(const DeviceSelection& selection)
+        {
+            if (selection.device == nullptr)
+            {
+                error_ = selection.error;
+                return false;
             }
 
-            iterator->Release(); // The iterator is no longer needed.
-
-            // Output interface of the specified device
-            res = device->QueryInterface(
+            // Output interface of the selected device
+            auto res = selection.device->QueryInterface(
                 IID_IDeckLinkOutput,
                 reinterpret_cast<void**>(&output_)
             );
 
-            device->Release(); // The device object is no longer needed.
+            selection.device->Release(); // The device object is no longer needed.
 
             if (res != S_OK)
             {
@@ -392,32 +1241,23 @@ namespace klinker
                 return false;
             }
 
-            // Display mode iterator
-            IDeckLinkDisplayModeIterator* dmIterator;
-            res = output_->GetDisplayModeIterator(&dmIterator);
-            assert(res == S_OK);
+            // Display mode object of the selected mode
+            BMDDisplayModeSupport support;
+            res = output_->DoesSupportVideoMode(
+                selection.mode, GetPixelFormat(), bmdVideoOutputFlagDefault,
+                &support, &displayMode_
+            );
 
-            // Iterate until reaching the specified index.
-            for (auto i = 0; i <= formatIndex; i++)
+            if (res != S_OK || displayMode_ == nullptr)
             {
-                if (displayMode_ != nullptr) displayMode_->Release();
-                res = dmIterator->Next(&displayMode_);
-
-                if (res != S_OK)
-                {
-                    error_ = "Invalid format index.";
-                    device->Release();
-                    dmIterator->Release();
-                    return false;
-                }
+                error_ = "Unsupported display mode or pixel format.";
+                return false;
             }
 
             // Get the frame rate defined in the display mode.
             res = displayMode_->GetFrameRate(&frameDuration_, &timeScale_);
             assert(res == S_OK);
 
-            dmIterator->Release(); // The iterator is no longer needed.
-
             // Set this object as a frame completion callback.
             res = output_->SetScheduledFrameCompletionCallback(this);
             assert(res == S_OK);
@@ -433,6 +1273,33 @@ namespace klinker
                 return false;
             }
 
+            // Enable the audio output.
+            if (settings_.audioChannelCount > 0)
+            {
+                res = output_->EnableAudioOutput(
+                    bmdAudioSampleRate48kHz,
+                    settings_.audioSampleDepth == 32 ?
+                        bmdAudioSampleType32bitInteger :
+                        bmdAudioSampleType16bitInteger,
+                    settings_.audioChannelCount,
+                    bmdAudioOutputStreamTimestamped
+                );
+
+                if (res != S_OK)
+                {
+                    error_ = "Can't enable audio output.";
+                    return false;
+                }
+
+                audioRing_.Reset(settings_.audioChannelCount, audioRingLength_, audioSampleRate_);
+                audioChunk_.assign(audioChunkLength_ * settings_.audioChannelCount, 0);
+                audioChunkRead_ = audioChunkCount_ = 0;
+                audioTime_ = 0;
+
+                res = output_->SetAudioCallback(this);
+                assert(res == S_OK);
+            }
+
             return true;
         }
 
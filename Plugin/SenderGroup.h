@@ -0,0 +1,160 @@
+#pragma once
+
+#include "Sender.h"
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace klinker
+{
+    //
+    // Sender group class
+    //
+    // Starts the playback of multiple senders in phase. The senders should
+    // be created with deferredStart, so they're prerolled but not started.
+    // Start polls the hardware reference clock of the first sender up to a
+    // frame boundary, which is used as the common origin. Each sender is
+    // started from the stream time that the first sender presents at its
+    // next frame boundary, so a sender started a frame late still plays in
+    // phase. (This assumes that the devices share a reference signal;
+    // Otherwise they drift apart anyway.)
+    //
+    // After the start, the phase drift of each sender is measured as the
+    // difference of the playhead stream time from the first sender.
+    //
+    // The group holds a reference to each sender, but it doesn't stop
+    // them; They should be destroyed individually.
+    //
+    class SenderGroup final
+    {
+    public:
+
+        #pragma region Constructor/destructor
+
+        ~SenderGroup()
+        {
+            for (auto sender : senders_) sender->Release();
+        }
+
+        #pragma endregion
+
+        #pragma region Public methods
+
+        void Add(Sender* sender)
+        {
+            sender->AddRef();
+            senders_.push_back(sender);
+        }
+
+        int GetCount() const
+        {
+            return static_cast<int>(senders_.size());
+        }
+
+        bool Start()
+        {
+            if (senders_.empty()) return false;
+
+            // Preroll the audio in advance to keep the starts back to back.
+            for (auto sender : senders_) sender->PreparePlayback();
+
+            // Common origin: The next frame boundary on the first sender
+            ClockSample origin;
+            auto timed = WaitForFrameBoundary(senders_[0], origin);
+            if (!timed) DebugLog("Sender group: Reference clock is not available.");
+
+            auto ok = true;
+
+            for (auto sender : senders_)
+            {
+                std::int64_t startTime = 0;
+                ClockSample sample;
+
+                if (timed && SampleClock(sender, sample))
+                {
+                    // Avoid starting right before a boundary; The start
+                    // might slip to the one after.
+                    if (sample.duration - sample.inFrame < startMargin_)
+                        WaitForFrameBoundary(sender, sample);
+
+                    // Frames elapsed on this sender since the origin. It
+                    // starts on the next boundary, where the first sender
+                    // presents the frame at this count.
+                    auto elapsed = ToFlicks(sample.host - origin.host) + origin.inFrame - sample.inFrame;
+                    auto frames = (elapsed + sample.duration / 2) / sample.duration;
+                    startTime = std::max<std::int64_t>(frames, 0) * sample.duration;
+                }
+
+                ok &= sender->StartPlayback(startTime);
+            }
+
+            return ok;
+        }
+
+        // Phase difference between a sender and the first sender in flicks
+        std::int64_t GetPhaseDrift(int index) const
+        {
+            if (index <= 0 || index >= GetCount()) return 0;
+
+            std::int64_t t0, h0, t1, h1;
+            if (!senders_[0]->GetPlaybackTime(t0, h0)) return 0;
+            if (!senders_[index]->GetPlaybackTime(t1, h1)) return 0;
+
+            // The playheads are read one after the other: Subtract the
+            // time elapsed between the readings.
+            return t1 - t0 - ToFlicks(h1 - h0);
+        }
+
+        #pragma endregion
+
+    private:
+
+        #pragma region Private members
+
+        static const std::int64_t startMargin_ = flicksPerSecond / 1000;
+
+        std::vector<Sender*> senders_;
+
+        // Hardware clock reading with the host time (us)
+        struct ClockSample
+        {
+            std::int64_t host, inFrame, duration;
+        };
+
+        static std::int64_t ToFlicks(std::int64_t microseconds)
+        {
+            return microseconds * (flicksPerSecond / 1000) / 1000;
+        }
+
+        static bool SampleClock(const Sender* sender, ClockSample& sample)
+        {
+            std::int64_t time;
+            if (!sender->GetHardwareClock(time, sample.inFrame, sample.duration)) return false;
+            sample.host = LatencyHistogram::GetHostTime();
+            return sample.duration > 0;
+        }
+
+        // Poll the clock up to a frame boundary. The OS sleep is too coarse
+        // for this (15.6ms on Windows by default). It gives up after two
+        // frames.
+        static bool WaitForFrameBoundary(const Sender* sender, ClockSample& sample)
+        {
+            if (!SampleClock(sender, sample)) return false;
+
+            auto last = sample.inFrame;
+            auto deadline = sample.host + 2 * sample.duration * 1000 / (flicksPerSecond / 1000);
+
+            while (sample.host < deadline)
+            {
+                std::this_thread::yield();
+                if (!SampleClock(sender, sample)) return false;
+                if (sample.inFrame < last) return true;
+                last = sample.inFrame;
+            }
+
+            return false;
+        }
+
+        #pragma endregion
+    };
+}
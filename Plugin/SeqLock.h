@@ -0,0 +1,115 @@
+#pragma once
+
+#include "Common.h"
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+namespace klinker
+{
+    //
+    // Sequence lock class
+    //
+    // Guards a small plain data structure that is updated by a single
+    // thread and read by any thread. The writer never waits: Readers copy
+    // the data and retry if it was modified during the copy (an odd
+    // sequence value means a write in progress), so they always get a
+    // consistent snapshot.
+    //
+    // Only one thread can update the data at a time. To record from
+    // multiple threads, give each writer its own instance (see
+    // StatisticsRecorder).
+    //
+    // The data is stored in relaxed atomic words, so the concurrent copies
+    // are well-defined.
+    //
+    template <typename T>
+    class SeqLock final
+    {
+    public:
+
+        static_assert(std::is_trivially_copyable<T>::value, "T should be trivially copyable.");
+        static_assert(sizeof(T) % sizeof(std::uint64_t) == 0, "T should be a multiple of 8 bytes.");
+
+        #pragma region Constructor
+
+        SeqLock()
+        {
+            Store(T{});
+        }
+
+        #pragma endregion
+
+        #pragma region Accessor methods
+
+        T Read() const
+        {
+            while (true)
+            {
+                auto seq = seq_.load(std::memory_order_acquire);
+
+                if (seq & 1)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                auto value = Load();
+                std::atomic_thread_fence(std::memory_order_acquire);
+
+                if (seq_.load(std::memory_order_relaxed) == seq) return value;
+            }
+        }
+
+        // Modify the data with a function (void(T&)). Writer thread only.
+        template <typename F>
+        void Update(F function)
+        {
+            // Even -> odd: Mark the write in progress.
+            auto seq = seq_.load(std::memory_order_relaxed);
+            seq_.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+
+            auto value = Load();
+            function(value);
+            Store(value);
+
+            // Odd -> even: Publish the data.
+            seq_.store(seq + 2, std::memory_order_release);
+        }
+
+        #pragma endregion
+
+    private:
+
+        #pragma region Private members
+
+        static const std::size_t wordCount_ = sizeof(T) / sizeof(std::uint64_t);
+
+        std::atomic<std::uint32_t> seq_ = 0;
+        std::atomic<std::uint64_t> words_[wordCount_];
+
+        T Load() const
+        {
+            std::uint64_t words[wordCount_];
+            for (std::size_t i = 0; i < wordCount_; i++)
+                words[i] = words_[i].load(std::memory_order_relaxed);
+
+            T value;
+            std::memcpy(&value, words, sizeof(T));
+            return value;
+        }
+
+        void Store(const T& value)
+        {
+            std::uint64_t words[wordCount_];
+            std::memcpy(words, &value, sizeof(T));
+
+            for (std::size_t i = 0; i < wordCount_; i++)
+                words_[i].store(words[i], std::memory_order_relaxed);
+        }
+
+        #pragma endregion
+    };
+}
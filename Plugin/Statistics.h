@@ -0,0 +1,279 @@
+#pragma once
+
+#include "Common.h"
+#include "LatencyHistogram.h"
+#include "SeqLock.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+namespace klinker
+{
+    //
+    // Statistics snapshot
+    //
+    // Plain data structure passed to the managed side. The layout should be
+    // kept in sync with Klinker.Statistics. Times are in microseconds. The
+    // counters that don't apply to the object type (the receiver or the
+    // sender) stay zero.
+    //
+    struct Statistics
+    {
+        std::int64_t framesIn;        // Arrived (receiver) / fed (sender)
+        std::int64_t framesOut;       // Dequeued (receiver) / completed (sender)
+
+        // Dropped frames by reason
+        std::int64_t dropsNewest;     // Arrived frames dropped on a full queue / no free output frame
+        std::int64_t dropsOldest;     // Queued frames dropped (DropOldest)
+        std::int64_t dropsSuperseded; // Replaced by newer ones before use
+        std::int64_t dropsOverqueue;  // Skipped on frame selection
+        std::int64_t dropsUnderrun;   // Frame selection underruns
+        std::int64_t dropsOutput;     // Dropped by the device
+        std::int64_t dropsFlushed;    // Flushed by the device
+        std::int64_t dropsRecovery;   // Dropped on late frame recovery
+        std::int64_t dropsPinned;     // Arrived frames dropped on a slot in use (any policy)
+
+        std::int64_t lateFrames;      // Displayed late
+
+        // Queue depth sampled on every push (receiver) / completion (sender)
+        std::int32_t queueDepthMin;
+        std::int32_t queueDepthMax;
+        double queueDepthAvg;
+
+        std::int64_t bytesCopied;     // Frame data copied/converted
+        std::int64_t copyTime;        // Total time spent on copying
+
+        std::int64_t callbackCount;   // Frame callbacks from the driver
+        std::int64_t callbackTime;    // Total duration of the callbacks
+        std::int64_t callbackTimeMax; // Longest callback duration
+
+        std::int64_t lockWaitTime;    // Total time blocked on contended locks
+    };
+
+    //
+    // Statistics recorder class
+    //
+    // Accumulates the counters in per-thread blocks, so the callback/render/
+    // worker threads can update them without waiting for each other. Each
+    // block is guarded by a sequence lock, and the snapshot merges them, so
+    // any thread can read it without blocking the updaters.
+    //
+    class StatisticsRecorder final
+    {
+    public:
+
+        // Raw counters (all 64-bit words)
+        struct Counters
+        {
+            std::int64_t framesIn, framesOut;
+            std::int64_t dropsNewest, dropsOldest, dropsSuperseded;
+            std::int64_t dropsOverqueue, dropsUnderrun;
+            std::int64_t dropsOutput, dropsFlushed, dropsRecovery;
+            std::int64_t dropsPinned;
+            std::int64_t lateFrames;
+            std::int64_t queueDepthMin, queueDepthMax;
+            std::int64_t queueDepthSum, queueDepthSamples;
+            std::int64_t bytesCopied, copyTime;
+            std::int64_t callbackCount, callbackTime, callbackTimeMax;
+            std::int64_t lockWaitTime;
+
+            void SampleQueueDepth(std::int64_t depth)
+            {
+                queueDepthMin = queueDepthSamples > 0 ? std::min(queueDepthMin, depth) : depth;
+                queueDepthMax = std::max(queueDepthMax, depth);
+                queueDepthSum += depth;
+                queueDepthSamples++;
+            }
+
+            void AddCallback(std::int64_t duration)
+            {
+                callbackCount++;
+                callbackTime += duration;
+                callbackTimeMax = std::max(callbackTimeMax, duration);
+            }
+
+            void AddCopy(std::int64_t bytes, std::int64_t duration)
+            {
+                bytesCopied += bytes;
+                copyTime += duration;
+            }
+
+            void Merge(const Counters& c)
+            {
+                if (c.queueDepthSamples > 0)
+                    queueDepthMin = queueDepthSamples > 0 ?
+                        std::min(queueDepthMin, c.queueDepthMin) : c.queueDepthMin;
+
+                framesIn += c.framesIn;
+                framesOut += c.framesOut;
+                dropsNewest += c.dropsNewest;
+                dropsOldest += c.dropsOldest;
+                dropsSuperseded += c.dropsSuperseded;
+                dropsOverqueue += c.dropsOverqueue;
+                dropsUnderrun += c.dropsUnderrun;
+                dropsOutput += c.dropsOutput;
+                dropsFlushed += c.dropsFlushed;
+                dropsRecovery += c.dropsRecovery;
+                dropsPinned += c.dropsPinned;
+                lateFrames += c.lateFrames;
+                queueDepthMax = std::max(queueDepthMax, c.queueDepthMax);
+                queueDepthSum += c.queueDepthSum;
+                queueDepthSamples += c.queueDepthSamples;
+                bytesCopied += c.bytesCopied;
+                copyTime += c.copyTime;
+                callbackCount += c.callbackCount;
+                callbackTime += c.callbackTime;
+                callbackTimeMax = std::max(callbackTimeMax, c.callbackTimeMax);
+                lockWaitTime += c.lockWaitTime;
+            }
+        };
+
+        #pragma region Recording methods
+
+        // Modify the counters with a function (void(Counters&)). It only
+        // touches the block of the calling thread.
+        template <typename F>
+        void Update(F function)
+        {
+            auto block = FindBlock();
+
+            if (block != nullptr)
+            {
+                block->counters.Update(function);
+                return;
+            }
+
+            // All the blocks are taken: Share the overflow block with the
+            // other extra threads. It only happens with many updater
+            // threads, which the plugin objects don't have.
+            while (overflowWriter_.test_and_set(std::memory_order_acquire))
+                std::this_thread::yield();
+            overflow_.Update(function);
+            overflowWriter_.clear(std::memory_order_release);
+        }
+
+        // Lock a mutex, recording the time spent on contention. The clock
+        // is only read when the mutex is not immediately available.
+        template <typename M>
+        std::unique_lock<M> Lock(M& mutex)
+        {
+            std::unique_lock<M> lock(mutex, std::try_to_lock);
+            if (lock.owns_lock()) return lock;
+
+            auto start = GetTime();
+            lock.lock();
+            auto wait = GetTime() - start;
+
+            Update([=](Counters& c) { c.lockWaitTime += wait; });
+            return lock;
+        }
+
+        static std::int64_t GetTime()
+        {
+            return LatencyHistogram::GetHostTime();
+        }
+
+        // Records the duration of a callback on leaving the scope.
+        class CallbackScope final
+        {
+        public:
+
+            explicit CallbackScope(StatisticsRecorder& recorder)
+              : recorder_(recorder), start_(GetTime()) {}
+
+            ~CallbackScope()
+            {
+                auto duration = GetTime() - start_;
+                recorder_.Update([=](Counters& c) { c.AddCallback(duration); });
+            }
+
+        private:
+
+            StatisticsRecorder& recorder_;
+            std::int64_t start_;
+        };
+
+        #pragma endregion
+
+        #pragma region Accessor methods
+
+        Counters GetCounters() const
+        {
+            auto c = overflow_.Read();
+            for (auto& block : blocks_) c.Merge(block.counters.Read());
+            return c;
+        }
+
+        Statistics GetSnapshot() const
+        {
+            auto c = GetCounters();
+
+            Statistics s = {};
+            s.framesIn = c.framesIn;
+            s.framesOut = c.framesOut;
+            s.dropsNewest = c.dropsNewest;
+            s.dropsOldest = c.dropsOldest;
+            s.dropsSuperseded = c.dropsSuperseded;
+            s.dropsOverqueue = c.dropsOverqueue;
+            s.dropsUnderrun = c.dropsUnderrun;
+            s.dropsOutput = c.dropsOutput;
+            s.dropsFlushed = c.dropsFlushed;
+            s.dropsRecovery = c.dropsRecovery;
+            s.dropsPinned = c.dropsPinned;
+            s.lateFrames = c.lateFrames;
+            s.queueDepthMin = static_cast<std::int32_t>(c.queueDepthMin);
+            s.queueDepthMax = static_cast<std::int32_t>(c.queueDepthMax);
+            s.queueDepthAvg = c.queueDepthSamples > 0 ?
+                static_cast<double>(c.queueDepthSum) / c.queueDepthSamples : 0;
+            s.bytesCopied = c.bytesCopied;
+            s.copyTime = c.copyTime;
+            s.callbackCount = c.callbackCount;
+            s.callbackTime = c.callbackTime;
+            s.callbackTimeMax = c.callbackTimeMax;
+            s.lockWaitTime = c.lockWaitTime;
+            return s;
+        }
+
+        #pragma endregion
+
+    private:
+
+        #pragma region Per-thread blocks
+
+        static const int maxWriters_ = 8;
+
+        struct Block
+        {
+            std::atomic<std::thread::id> owner;
+            SeqLock<Counters> counters;
+        };
+
+        Block blocks_[maxWriters_];
+        SeqLock<Counters> overflow_;
+        std::atomic_flag overflowWriter_ = ATOMIC_FLAG_INIT;
+
+        // Find the block owned by the calling thread, or claim a free one.
+        // Returns null when all the blocks are taken.
+        Block* FindBlock()
+        {
+            auto self = std::this_thread::get_id();
+
+            for (auto& block : blocks_)
+            {
+                auto owner = block.owner.load(std::memory_order_relaxed);
+                if (owner == self) return &block;
+                if (owner != std::thread::id()) continue;
+
+                // A free block: Claim it. A claimed block is never released,
+                // so the first free one is always after the owned ones.
+                if (block.owner.compare_exchange_strong(owner, self, std::memory_order_relaxed))
+                    return &block;
+            }
+
+            return nullptr;
+        }
+
+        #pragma endregion
+    };
+}
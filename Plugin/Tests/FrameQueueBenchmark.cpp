@@ -0,0 +1,199 @@
+//
+// Frame queue contention benchmark
+//
+// Compares the lock-free frame queue with the former mutex-guarded
+// std::queue under a synthetic 120 fps producer (the capture callback) and
+// a render thread that holds the oldest frame while uploading it.
+//
+// It measures the producer time per frame (including the frame copy). With
+// the mutex queue, the producer waits for the whole upload; With the
+// lock-free queue, it should never wait. Run it on a multi-core machine.
+//
+// This is a standalone console program that is not part of the plugin
+// build. Build it from the Developer Command Prompt:
+//
+//   cl /EHsc /O2 /std:c++17 FrameQueueBenchmark.cpp
+//
+
+#include "../FrameQueue.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Synthetic workload: 1080p UYVY at 120 fps, 3 seconds
+    const std::size_t frameSize = 1920 * 1080 * 2;
+    const int frameRate = 120;
+    const int frameCount = frameRate * 3;
+
+    // Time the render thread keeps the frame after copying it (GPU wait)
+    const auto uploadWait = std::chrono::microseconds(3000);
+
+    void WaitUntil(Clock::time_point time)
+    {
+        // Spin with yielding: The OS sleep is too coarse for 120 fps.
+        while (Clock::now() < time) std::this_thread::yield();
+    }
+
+    struct Result
+    {
+        double average, percentile99, max; // Producer time per frame (us)
+        int drops;
+    };
+
+    Result Summarize(std::vector<double>& samples, int drops)
+    {
+        std::sort(samples.begin(), samples.end());
+        double sum = 0;
+        for (auto s : samples) sum += s;
+        return {
+            sum / samples.size(),
+            samples[samples.size() * 99 / 100],
+            samples.back(), drops
+        };
+    }
+
+    template <typename Queue>
+    Result Run()
+    {
+        Queue queue;
+        std::vector<double> samples;
+        auto drops = 0;
+        auto done = false;
+        std::mutex doneMutex;
+
+        std::vector<std::uint8_t> source(frameSize, 0x80);
+        std::vector<std::uint8_t> texture(frameSize);
+
+        // Render thread: Upload and dequeue the oldest frame.
+        std::thread render([&]()
+        {
+            for (;;)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(doneMutex);
+                    if (done) break;
+                }
+                if (!queue.Upload(texture.data())) std::this_thread::yield();
+            }
+        });
+
+        // Producer: Push a frame every 1/120 s.
+        auto start = Clock::now();
+        for (auto i = 0; i < frameCount; i++)
+        {
+            WaitUntil(start + std::chrono::microseconds(1000000LL * i / frameRate));
+
+            auto t0 = Clock::now();
+            if (!queue.Push(source.data())) drops++;
+            auto t1 = Clock::now();
+
+            samples.push_back(std::chrono::duration<double, std::micro>(t1 - t0).count());
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(doneMutex);
+            done = true;
+        }
+        render.join();
+
+        return Summarize(samples, drops);
+    }
+
+    //
+    // Former implementation: std::queue + mutex, locked while uploading
+    //
+    class MutexQueue
+    {
+    public:
+
+        bool Push(const std::uint8_t* source)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (queue_.size() >= depth_) queue_.pop();
+            queue_.emplace(source, source + frameSize);
+            return true;
+        }
+
+        bool Upload(std::uint8_t* dest)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (queue_.empty()) return false;
+            std::memcpy(dest, queue_.front().data(), frameSize);
+            WaitUntil(Clock::now() + uploadWait);
+            queue_.pop();
+            return true;
+        }
+
+    private:
+
+        static const std::size_t depth_ = 8;
+        std::queue<std::vector<std::uint8_t>> queue_;
+        std::mutex mutex_;
+    };
+
+    //
+    // Current implementation: Lock-free ring with reader pins
+    //
+    class RingQueue
+    {
+    public:
+
+        RingQueue()
+        {
+            queue_.Reset(depth_ + klinker::FrameQueue<Frame>::maxReaders);
+            for (std::size_t i = 0; i < queue_.GetCapacity(); i++)
+                queue_.GetSlot(i).resize(frameSize);
+        }
+
+        bool Push(const std::uint8_t* source)
+        {
+            while (queue_.CountQueued() >= depth_) queue_.Pop();
+            auto slot = queue_.BeginPush();
+            if (slot == nullptr) return false;
+            std::memcpy(slot->data(), source, frameSize);
+            queue_.EndPush();
+            return true;
+        }
+
+        bool Upload(std::uint8_t* dest)
+        {
+            auto frame = queue_.Pin();
+            if (frame == nullptr) return false;
+            std::memcpy(dest, frame->data(), frameSize);
+            WaitUntil(Clock::now() + uploadWait);
+            queue_.PopPinned(0);
+            queue_.Unpin();
+            return true;
+        }
+
+    private:
+
+        using Frame = std::vector<std::uint8_t>;
+        static const std::size_t depth_ = 8;
+        klinker::FrameQueue<Frame> queue_;
+    };
+
+    void Print(const char* label, const Result& r)
+    {
+        std::printf(
+            "%-12s avg %8.1f us   p99 %8.1f us   max %8.1f us   drops %d\n",
+            label, r.average, r.percentile99, r.max, r.drops
+        );
+    }
+}
+
+int main()
+{
+    std::printf("Producer time per frame (1080p UYVY, %d fps, %d frames)\n", frameRate, frameCount);
+    Print("std::queue", Run<MutexQueue>());
+    Print("FrameQueue", Run<RingQueue>());
+    return 0;
+}
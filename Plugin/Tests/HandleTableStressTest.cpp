@@ -0,0 +1,146 @@
+//
+// Handle table stress test
+//
+// Creates and destroys objects on several threads while other threads keep
+// looking up random (mostly stale) handles, as the render thread does. The
+// objects are poisoned on destruction, so an access to a destroyed object
+// is detected. It also checks the behavior on a full table.
+//
+// This is a standalone console program that is not part of the plugin
+// build. Build it from the Developer Command Prompt:
+//
+//   cl /EHsc /O2 /std:c++17 HandleTableStressTest.cpp
+//
+// It returns a non-zero exit code on failure.
+//
+
+#include "../HandleTable.h"
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using klinker::HandleTable;
+
+    const int writerCount = 4;
+    const int readerCount = 4;
+    const int cyclesPerWriter = 20000;
+
+    const std::uint32_t aliveMark = 0x12345678;
+    const std::uint32_t deadMark = 0xdeadbeef;
+
+    struct Object
+    {
+        std::atomic<std::uint32_t> mark = aliveMark;
+    };
+
+    bool TestFullTable()
+    {
+        HandleTable<Object> table;
+        std::vector<Object> objects(HandleTable<Object>::capacity + 1);
+        std::vector<std::uint32_t> handles;
+
+        // Fill the table up.
+        for (auto i = 0; i < HandleTable<Object>::capacity; i++)
+        {
+            auto handle = table.Add(&objects[i]);
+            if (handle == 0) return false;
+            handles.push_back(handle);
+        }
+
+        // No room: Zero should be returned.
+        if (table.Add(&objects.back()) != 0) return false;
+
+        // Free a slot: The new handle should differ from the stale one.
+        table.Remove(handles[0]);
+        auto handle = table.Add(&objects.back());
+        if (handle == 0 || handle == handles[0]) return false;
+
+        // The stale handle should never resolve.
+        if (table.Access(handles[0], [](Object*) {})) return false;
+
+        return true;
+    }
+
+    bool TestConcurrentAccess()
+    {
+        HandleTable<Object> table;
+
+        // Recently issued handles (read by the lookup threads)
+        std::atomic<std::uint32_t> published[16] = {};
+
+        std::atomic<bool> stop = false;
+        std::atomic<long> hits = 0, misses = 0, errors = 0;
+
+        std::vector<std::thread> writers, readers;
+
+        // Create/destroy threads
+        for (auto w = 0; w < writerCount; w++)
+        {
+            writers.emplace_back([&, w]()
+            {
+                std::mt19937 rng(w);
+
+                for (auto i = 0; i < cyclesPerWriter; i++)
+                {
+                    auto object = new Object();
+                    auto handle = table.Add(object);
+
+                    if (handle == 0)
+                    {
+                        delete object;
+                        continue;
+                    }
+
+                    published[rng() % 16] = handle;
+                    std::this_thread::yield();
+
+                    table.Remove(handle);
+                    object->mark = deadMark;
+                    delete object;
+                }
+            });
+        }
+
+        // Lookup threads
+        for (auto r = 0; r < readerCount; r++)
+        {
+            readers.emplace_back([&, r]()
+            {
+                std::mt19937 rng(100 + r);
+
+                while (!stop)
+                {
+                    auto handle = published[rng() % 16].load();
+
+                    auto found = table.Access(handle, [&](Object* object)
+                    {
+                        if (object == nullptr || object->mark != aliveMark) errors++;
+                    });
+
+                    if (found) hits++; else misses++;
+                    std::this_thread::yield();
+                }
+            });
+        }
+
+        for (auto& t : writers) t.join();
+        stop = true;
+        for (auto& t : readers) t.join();
+
+        std::printf("Lookups: %ld hits, %ld misses, %ld errors\n", hits.load(), misses.load(), errors.load());
+        return errors == 0;
+    }
+}
+
+int main()
+{
+    auto full = TestFullTable();
+    std::printf("Full table: %s\n", full ? "ok" : "FAILED");
+
+    auto concurrent = TestConcurrentAccess();
+    std::printf("Concurrent access: %s\n", concurrent ? "ok" : "FAILED");
+
+    return full && concurrent ? 0 : 1;
+}
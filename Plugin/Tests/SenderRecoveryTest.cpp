@@ -0,0 +1,121 @@
+//
+// Sender late frame recovery test
+//
+// Simulates the async mode scheduling (one frame rescheduled per
+// completion) with repeated host stalls, which trigger a recovery each
+// time. The number of frames in flight should stay at the preroll depth
+// with every policy. It also shows that applying Drop in the async mode
+// would drain the frames in flight and stall the output.
+//
+// This is a standalone console program that is not part of the plugin
+// build. Build it from the Developer Command Prompt:
+//
+//   cl /EHsc /O2 /std:c++17 SenderRecoveryTest.cpp
+//
+// It returns a non-zero exit code on failure.
+//
+
+#include "../Sender.h"
+#include <deque>
+
+namespace
+{
+    using klinker::LateFramePolicy;
+    using klinker::LateFrameRecovery;
+
+    const std::int64_t frameDuration = 1000;
+    const int preroll = 3;
+    const int tickCount = 2000;
+    const int stallInterval = 50; // A host stall every 50 frames
+    const int stallLength = 10;   // lasting 10 frames
+
+    struct Result
+    {
+        int inFlight;   // Frames in flight at the end
+        int recoveries;
+        int drops;
+    };
+
+    // forceDrop: Apply Drop regardless of the mode (the former behavior)
+    Result Simulate(LateFramePolicy policy, bool forceDrop)
+    {
+        std::deque<std::int64_t> scheduled; // Stream times of the frames in flight
+        std::int64_t queued = 0;
+        Result result = {};
+
+        auto schedule = [&](std::int64_t playhead)
+        {
+            auto position = LateFrameRecovery::SkipAhead(queued, frameDuration, playhead, preroll);
+
+            if (position >= 0)
+            {
+                queued = position;
+                result.recoveries++;
+
+                auto drop = forceDrop ?
+                    policy == LateFramePolicy::Drop :
+                    LateFrameRecovery::ShouldDrop(policy, true);
+
+                if (drop)
+                {
+                    result.drops++;
+                    return;
+                }
+            }
+
+            scheduled.push_back(frameDuration * queued++);
+        };
+
+        // Prerolling
+        for (auto i = 0; i < preroll; i++) schedule(0);
+
+        for (auto tick = 1; tick <= tickCount; tick++)
+        {
+            auto playhead = frameDuration * tick;
+
+            // The completion callbacks are held back during a stall.
+            if (tick % stallInterval < stallLength) continue;
+
+            // Completions (one reschedule for each)
+            while (!scheduled.empty() && scheduled.front() + frameDuration <= playhead)
+            {
+                scheduled.pop_front();
+                schedule(playhead);
+            }
+        }
+
+        result.inFlight = static_cast<int>(scheduled.size());
+        return result;
+    }
+
+    bool Check(const char* label, const Result& r, bool expectStall)
+    {
+        auto ok = r.recoveries > 0 && (expectStall ? r.inFlight == 0 : r.inFlight == preroll);
+        std::printf(
+            "%-22s in flight %d, recoveries %d, drops %d: %s\n",
+            label, r.inFlight, r.recoveries, r.drops, ok ? "ok" : "FAILED"
+        );
+        return ok;
+    }
+}
+
+int main()
+{
+    auto ok = true;
+
+    ok &= Check("Async Repeat", Simulate(LateFramePolicy::Repeat, false), false);
+    ok &= Check("Async Drop", Simulate(LateFramePolicy::Drop, false), false);
+
+    // The former behavior: Drop applied in the async mode stalls.
+    ok &= Check("Async Drop (former)", Simulate(LateFramePolicy::Drop, true), true);
+
+    // Manual mode: Drop discards the frame; The others schedule it.
+    auto manual =
+        LateFrameRecovery::ShouldDrop(LateFramePolicy::Drop, false) &&
+        !LateFrameRecovery::ShouldDrop(LateFramePolicy::Repeat, false) &&
+        !LateFrameRecovery::ShouldDrop(LateFramePolicy::Drop, true);
+    std::printf("Manual mode policies: %s\n", manual ? "ok" : "FAILED");
+    ok &= manual;
+
+    return ok ? 0 : 1;
+}
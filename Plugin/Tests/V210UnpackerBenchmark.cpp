@@ -0,0 +1,97 @@
+//
+// v210 unpacker microbenchmark
+//
+// Measures the scalar, SSE4.1 and AVX2 unpack kernels with 1080p and 2160p
+// frames. The SIMD results are also checked against the scalar kernel, as
+// they should be bit-identical.
+//
+// This is a standalone console program that is not part of the plugin
+// build. Build it from the Developer Command Prompt:
+//
+//   cl /EHsc /O2 /std:c++17 V210UnpackerBenchmark.cpp
+//
+
+#include "../V210Unpacker.h"
+#include <chrono>
+#include <random>
+#include <vector>
+
+namespace
+{
+    using klinker::CpuFeatures;
+    using klinker::V210Unpacker;
+    using Kernel = V210Unpacker::Kernel;
+    using Clock = std::chrono::steady_clock;
+
+    const int iterations = 50;
+
+    struct Frame
+    {
+        int width, height;
+        std::size_t rowBytes;
+        std::vector<std::uint8_t> source;
+
+        Frame(int w, int h)
+          : width(w), height(h), rowBytes(V210Unpacker::GetRowBytes(w)),
+            source(rowBytes * h)
+        {
+            // Random 10-bit samples (the top two bits are unused)
+            std::mt19937 rng(1);
+            auto words = reinterpret_cast<std::uint32_t*>(source.data());
+            for (std::size_t i = 0; i < source.size() / 4; i++)
+                words[i] = rng() & 0x3fffffffU;
+        }
+
+        std::vector<std::uint8_t> Unpack(Kernel kernel) const
+        {
+            std::vector<std::uint8_t> dest(V210Unpacker::GetUnpackedSize(width, height));
+            V210Unpacker::UnpackFrame(source.data(), rowBytes, dest.data(), width, height, kernel);
+            return dest;
+        }
+    };
+
+    void Measure(const Frame& frame, Kernel kernel, const char* label)
+    {
+        std::vector<std::uint8_t> dest(V210Unpacker::GetUnpackedSize(frame.width, frame.height));
+
+        // Warm up
+        V210Unpacker::UnpackFrame(frame.source.data(), frame.rowBytes, dest.data(), frame.width, frame.height, kernel);
+
+        auto start = Clock::now();
+        for (auto i = 0; i < iterations; i++)
+            V210Unpacker::UnpackFrame(frame.source.data(), frame.rowBytes, dest.data(), frame.width, frame.height, kernel);
+        auto time = std::chrono::duration<double>(Clock::now() - start).count() / iterations;
+
+        // Throughput in the source pixels
+        auto mpixels = (double)frame.width * frame.height / time / 1e6;
+        auto match = frame.Unpack(Kernel::Scalar) == dest;
+
+        std::printf(
+            "%4dx%-4d  %-7s  %7.3f ms  %8.1f Mpixel/s  %s\n",
+            frame.width, frame.height, label, time * 1e3, mpixels,
+            match ? "ok" : "MISMATCH"
+        );
+    }
+}
+
+int main()
+{
+    for (auto size : { std::make_pair(1920, 1080), std::make_pair(3840, 2160) })
+    {
+        Frame frame(size.first, size.second);
+
+        Measure(frame, Kernel::Scalar, "Scalar");
+
+        if (CpuFeatures::HasSSE41())
+            Measure(frame, Kernel::SSE41, "SSE4.1");
+        else
+            std::printf("SSE4.1 is not available.\n");
+
+        if (CpuFeatures::HasAVX2())
+            Measure(frame, Kernel::AVX2, "AVX2");
+        else
+            std::printf("AVX2 is not available.\n");
+    }
+
+    return 0;
+}
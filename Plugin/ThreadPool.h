@@ -0,0 +1,142 @@
+#pragma once
+
+#include "Common.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace klinker
+{
+    //
+    // Thread pool class
+    //
+    // A minimal fork-join pool for data-parallel jobs. Run() splits a job
+    // into a given number of tasks, executes them on the worker threads and
+    // the calling thread, then waits for completion. Only one job can be
+    // run at a time.
+    //
+    class ThreadPool final
+    {
+    public:
+
+        using TaskFunction = void (*)(void* context, int index);
+
+        #pragma region Constructor/destructor
+
+        // Zero or less selects the number of the hardware threads.
+        ThreadPool(int threadCount = 0)
+        {
+            if (threadCount <= 0)
+                threadCount = static_cast<int>(std::thread::hardware_concurrency());
+
+            // The calling thread also works as a worker.
+            for (auto i = 1; i < threadCount; i++)
+                workers_.emplace_back([this]() { WorkerLoop(); });
+        }
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                quit_ = true;
+            }
+
+            start_.notify_all();
+            for (auto& t : workers_) t.join();
+        }
+
+        #pragma endregion
+
+        #pragma region Public methods
+
+        int GetThreadCount() const
+        {
+            return static_cast<int>(workers_.size()) + 1;
+        }
+
+        void Run(int taskCount, TaskFunction function, void* context)
+        {
+            std::lock_guard<std::mutex> runLock(runMutex_);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                function_ = function;
+                context_ = context;
+                taskCount_ = taskCount;
+                nextTask_ = 0;
+                busyWorkers_ = static_cast<int>(workers_.size());
+                generation_++;
+            }
+
+            start_.notify_all();
+
+            // Process tasks on this thread too.
+            ProcessTasks();
+
+            // Wait for the workers.
+            std::unique_lock<std::mutex> lock(mutex_);
+            done_.wait(lock, [this]() { return busyWorkers_ == 0; });
+        }
+
+        #pragma endregion
+
+    private:
+
+        #pragma region Private members
+
+        std::vector<std::thread> workers_;
+
+        std::mutex runMutex_;
+        std::mutex mutex_;
+        std::condition_variable start_;
+        std::condition_variable done_;
+
+        TaskFunction function_ = nullptr;
+        void* context_ = nullptr;
+        int taskCount_ = 0;
+        std::atomic<int> nextTask_ = 0;
+        int busyWorkers_ = 0;
+        std::uint64_t generation_ = 0;
+        bool quit_ = false;
+
+        void ProcessTasks()
+        {
+            for (;;)
+            {
+                auto index = nextTask_.fetch_add(1);
+                if (index >= taskCount_) break;
+                function_(context_, index);
+            }
+        }
+
+        void WorkerLoop()
+        {
+            std::uint64_t generation = 0;
+
+            for (;;)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    start_.wait(lock, [&]() {
+                        return quit_ || generation_ != generation;
+                    });
+                    if (quit_) return;
+                    generation = generation_;
+                }
+
+                ProcessTasks();
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    busyWorkers_--;
+                }
+
+                done_.notify_one();
+            }
+        }
+
+        #pragma endregion
+    };
+}
@@ -0,0 +1,225 @@
+#pragma once
+
+#include "CpuFeatures.h"
+#include <cstring>
+#include <immintrin.h>
+
+namespace klinker
+{
+    //
+    // v210 unpacker class
+    //
+    // Unpacks 10-bit 4:2:2 (v210) frames into a GPU-friendly 16-bit layout:
+    // UYVY-ordered half-precision floats, which can be uploaded to an
+    // RGBAHalf texture (one texel per two pixels) just like the 8-bit UYVY
+    // frames are uploaded to an RGBA32 texture.
+    //
+    // Sample values are normalized with 8-bit code values (x / 1020), so
+    // 64 (black) and 940 (white) are mapped to 16/255 and 235/255. This
+    // keeps the upsampler contract identical between the two formats.
+    //
+    // In v210, each 32-bit word contains three consecutive samples of the
+    // UYVY stream, and six pixels are packed into a 128-bit block.
+    //
+    class V210Unpacker final
+    {
+    public:
+
+        // Row pitch of a v210 frame (48 pixels per 128 bytes)
+        static std::size_t GetRowBytes(int width)
+        {
+            return (std::size_t)(width + 47) / 48 * 128;
+        }
+
+        // Data size of an unpacked frame
+        static std::size_t GetUnpackedSize(int width, int height)
+        {
+            return (std::size_t)4 * width * height;
+        }
+
+        // Kernel selection (Auto: the fastest one the CPU supports)
+        // The others are for testing and benchmarking.
+        enum class Kernel { Auto, Scalar, SSE41, AVX2 };
+
+        static void UnpackFrame(
+            const void* source, std::size_t sourceRowBytes,
+            void* dest, int width, int height,
+            Kernel selection = Kernel::Auto
+        )
+        {
+            auto kernel = SelectKernel(selection);
+
+            auto src = static_cast<const std::uint8_t*>(source);
+            auto dst = static_cast<std::uint16_t*>(dest);
+
+            for (auto y = 0; y < height; y++)
+            {
+                kernel(reinterpret_cast<const std::uint32_t*>(src), dst, width);
+                src += sourceRowBytes;
+                dst += (std::size_t)2 * width;
+            }
+        }
+
+    private:
+
+        #pragma region Kernel selector
+
+        using RowKernel = void (*)(const std::uint32_t*, std::uint16_t*, int);
+
+        static RowKernel SelectKernel(Kernel selection)
+        {
+            if (selection == Kernel::Scalar) return UnpackRowScalar;
+            if (selection == Kernel::SSE41) return UnpackRowSSE41;
+            if (selection == Kernel::AVX2) return UnpackRowAVX2;
+            if (CpuFeatures::HasAVX2()) return UnpackRowAVX2;
+            if (CpuFeatures::HasSSE41()) return UnpackRowSSE41;
+            return UnpackRowScalar;
+        }
+
+        #pragma endregion
+
+        #pragma region Scalar implementation
+
+        // 10-bit sample -> normalized half-precision float
+        //
+        // It converts the float bits with round-half-up. The value range is
+        // always in the half normal range except zero. The SIMD kernels use
+        // the exactly same arithmetic, so the results are bit-identical.
+        static std::uint16_t ToHalf(std::uint32_t x)
+        {
+            auto f = static_cast<float>(x) * (1.0f / 1020);
+            std::uint32_t bits;
+            std::memcpy(&bits, &f, sizeof(bits));
+            if (x == 0) return 0;
+            return static_cast<std::uint16_t>(((bits + 0x1000) >> 13) - 0x1c000);
+        }
+
+        static void UnpackRowScalar(const std::uint32_t* src, std::uint16_t* dst, int width)
+        {
+            auto count = width * 2; // Sample count
+
+            // Full words
+            for (; count >= 3; count -= 3, src++, dst += 3)
+            {
+                dst[0] = ToHalf((*src      ) & 0x3ff);
+                dst[1] = ToHalf((*src >> 10) & 0x3ff);
+                dst[2] = ToHalf((*src >> 20) & 0x3ff);
+            }
+
+            // Remaining samples
+            for (auto i = 0; i < count; i++)
+                dst[i] = ToHalf((*src >> (i * 10)) & 0x3ff);
+        }
+
+        #pragma endregion
+
+        #pragma region SSE4.1 implementation
+
+        static __m128i ToHalf(__m128i x)
+        {
+            auto f = _mm_mul_ps(_mm_cvtepi32_ps(x), _mm_set1_ps(1.0f / 1020));
+            auto h = _mm_add_epi32(_mm_castps_si128(f), _mm_set1_epi32(0x1000));
+            h = _mm_sub_epi32(_mm_srli_epi32(h, 13), _mm_set1_epi32(0x1c000));
+            return _mm_andnot_si128(_mm_cmpeq_epi32(x, _mm_setzero_si128()), h);
+        }
+
+        // Byte shuffle tables for interleaving the unpacked samples
+        //
+        // Input: p01 = (U0 U1 U2 U3 V0 V1 V2 V3), p22 = (W0 W1 W2 W3 ...)
+        // where U, V, W are the 1st, 2nd, 3rd sample in the n-th word.
+        //
+        // Output: (U0 V0 W0 U1 V1 W1 U2 V2) (W2 U3 V3 W3)
+        //
+        #define KLINKER_V210_SHUFFLE_A0 0,1, 8,9, -1,-1, 2,3, 10,11, -1,-1, 4,5, 12,13
+        #define KLINKER_V210_SHUFFLE_B0 -1,-1, -1,-1, 0,1, -1,-1, -1,-1, 2,3, -1,-1, -1,-1
+        #define KLINKER_V210_SHUFFLE_A1 -1,-1, 6,7, 14,15, -1,-1, -1,-1, -1,-1, -1,-1, -1,-1
+        #define KLINKER_V210_SHUFFLE_B1 4,5, -1,-1, -1,-1, 6,7, -1,-1, -1,-1, -1,-1, -1,-1
+
+        static void UnpackRowSSE41(const std::uint32_t* src, std::uint16_t* dst, int width)
+        {
+            const auto mask = _mm_set1_epi32(0x3ff);
+            const auto a0 = _mm_setr_epi8(KLINKER_V210_SHUFFLE_A0);
+            const auto b0 = _mm_setr_epi8(KLINKER_V210_SHUFFLE_B0);
+            const auto a1 = _mm_setr_epi8(KLINKER_V210_SHUFFLE_A1);
+            const auto b1 = _mm_setr_epi8(KLINKER_V210_SHUFFLE_B1);
+
+            // 128-bit block = 4 words = 6 pixels = 12 samples
+            auto blocks = width / 6;
+
+            for (auto i = 0; i < blocks; i++, src += 4, dst += 12)
+            {
+                auto w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+
+                auto h0 = ToHalf(_mm_and_si128(w, mask));
+                auto h1 = ToHalf(_mm_and_si128(_mm_srli_epi32(w, 10), mask));
+                auto h2 = ToHalf(_mm_and_si128(_mm_srli_epi32(w, 20), mask));
+
+                auto p01 = _mm_packus_epi32(h0, h1);
+                auto p22 = _mm_packus_epi32(h2, h2);
+
+                auto out0 = _mm_or_si128(_mm_shuffle_epi8(p01, a0), _mm_shuffle_epi8(p22, b0));
+                auto out1 = _mm_or_si128(_mm_shuffle_epi8(p01, a1), _mm_shuffle_epi8(p22, b1));
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), out0);
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + 8), out1);
+            }
+
+            // Remaining pixels
+            UnpackRowScalar(src, dst, width - blocks * 6);
+        }
+
+        #pragma endregion
+
+        #pragma region AVX2 implementation
+
+        static __m256i ToHalf(__m256i x)
+        {
+            auto f = _mm256_mul_ps(_mm256_cvtepi32_ps(x), _mm256_set1_ps(1.0f / 1020));
+            auto h = _mm256_add_epi32(_mm256_castps_si256(f), _mm256_set1_epi32(0x1000));
+            h = _mm256_sub_epi32(_mm256_srli_epi32(h, 13), _mm256_set1_epi32(0x1c000));
+            return _mm256_andnot_si256(_mm256_cmpeq_epi32(x, _mm256_setzero_si256()), h);
+        }
+
+        static void UnpackRowAVX2(const std::uint32_t* src, std::uint16_t* dst, int width)
+        {
+            const auto mask = _mm256_set1_epi32(0x3ff);
+            const auto a0 = _mm256_setr_epi8(KLINKER_V210_SHUFFLE_A0, KLINKER_V210_SHUFFLE_A0);
+            const auto b0 = _mm256_setr_epi8(KLINKER_V210_SHUFFLE_B0, KLINKER_V210_SHUFFLE_B0);
+            const auto a1 = _mm256_setr_epi8(KLINKER_V210_SHUFFLE_A1, KLINKER_V210_SHUFFLE_A1);
+            const auto b1 = _mm256_setr_epi8(KLINKER_V210_SHUFFLE_B1, KLINKER_V210_SHUFFLE_B1);
+
+            // Two blocks per iteration (packing/shuffling is done per lane)
+            auto pairs = width / 12;
+
+            for (auto i = 0; i < pairs; i++, src += 8, dst += 24)
+            {
+                auto w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+
+                auto h0 = ToHalf(_mm256_and_si256(w, mask));
+                auto h1 = ToHalf(_mm256_and_si256(_mm256_srli_epi32(w, 10), mask));
+                auto h2 = ToHalf(_mm256_and_si256(_mm256_srli_epi32(w, 20), mask));
+
+                auto p01 = _mm256_packus_epi32(h0, h1);
+                auto p22 = _mm256_packus_epi32(h2, h2);
+
+                auto out0 = _mm256_or_si256(_mm256_shuffle_epi8(p01, a0), _mm256_shuffle_epi8(p22, b0));
+                auto out1 = _mm256_or_si256(_mm256_shuffle_epi8(p01, a1), _mm256_shuffle_epi8(p22, b1));
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst +  0), _mm256_castsi256_si128(out0));
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(dst +  8), _mm256_castsi256_si128(out1));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 12), _mm256_extracti128_si256(out0, 1));
+                _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + 20), _mm256_extracti128_si256(out1, 1));
+            }
+
+            // Remaining blocks and pixels
+            UnpackRowSSE41(src, dst, width - pairs * 12);
+        }
+
+        #undef KLINKER_V210_SHUFFLE_A0
+        #undef KLINKER_V210_SHUFFLE_B0
+        #undef KLINKER_V210_SHUFFLE_A1
+        #undef KLINKER_V210_SHUFFLE_B1
+
+        #pragma endregion
+    };
+}